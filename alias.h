@@ -0,0 +1,90 @@
+#ifndef __ALIAS_H__
+#define __ALIAS_H__
+
+#include <algorithm>
+#include <cstdint>
+
+// Walker's alias method: draws one of N outcomes with given weights from a
+// single 64-bit random number in constant time. Weights are normalized to
+// integers summing to exactly 2^32, so the table never runs off the end of
+// the distribution and outcomes of weight 0 are never drawn.
+template <int N>
+class AliasTable {
+  public:
+    AliasTable() {}
+
+    explicit AliasTable(const float* weights) {
+      double sum = 0.0;
+      for (int i=0; i<N; i++) sum += weights[i];
+
+      // Fixed-point weights, with the rounding error given to the heaviest
+      uint64_t scaled[N];
+      uint64_t total = 0;
+      int heaviest = 0;
+
+      for (int i=0; i<N; i++) {
+        scaled[i] = static_cast<uint64_t>(weights[i] / sum * ONE + 0.5);
+        total += scaled[i];
+        if (weights[i] > weights[heaviest]) heaviest = i;
+      }
+
+      scaled[heaviest] += ONE - total;
+
+      // Each column holds N/2^32 of the mass; split it between the column's
+      // own outcome and one alias
+      int small[N], large[N];
+      int numSmall = 0, numLarge = 0;
+
+      for (int i=0; i<N; i++) {
+        scaled[i] *= N;
+        alias[i] = i;
+        if (scaled[i] < ONE) small[numSmall++] = i;
+        else large[numLarge++] = i;
+      }
+
+      while (numSmall > 0 && numLarge > 0) {
+        const int s = small[--numSmall];
+        const int l = large[numLarge - 1];
+
+        threshold[s] = scaled[s];
+        alias[s] = l;
+        scaled[l] -= ONE - scaled[s];
+
+        if (scaled[l] < ONE) {
+          numLarge--;
+          small[numSmall++] = l;
+        }
+      }
+
+      // The integer weights sum exactly, so whatever is left fills its column
+      while (numLarge > 0) threshold[large[--numLarge]] = ONE;
+      while (numSmall > 0) threshold[small[--numSmall]] = ONE;
+    }
+
+    // The high 32 bits of draw pick a column and the low 32 bits pick
+    // between the column's outcome and its alias
+    int sample(uint64_t draw) const {
+      const int column = static_cast<int>(((draw >> 32) * N) >> 32);
+      return (draw & (ONE - 1)) < threshold[column] ? column : alias[column];
+    }
+
+    // The probability sample gives outcome i over uniform draws
+    double probability(int i) const {
+      double p = 0.0;
+
+      for (int column=0; column<N; column++) {
+        if (column == i) p += threshold[column];
+        if (alias[column] == i) p += ONE - threshold[column];
+      }
+
+      return p / ONE / N;
+    }
+
+  private:
+    static const uint64_t ONE = 1ULL << 32;
+
+    uint64_t threshold[N] = {};
+    int alias[N] = {};
+};
+
+#endif
@@ -11,8 +11,8 @@ void report(const BoardPtr& b, const Tile& tile) {
 #ifdef DEBUG
   cout << *b;
 #else
-  for (const auto& t: b->board) {
-    cout << t << ' ';
+  for (int i=0; i<BOARD_SIZE; i++) {
+    cout << b->board[i] << ' ';
   }
   cout << '\n';
 #endif
@@ -20,10 +20,7 @@ void report(const BoardPtr& b, const Tile& tile) {
   cout << b->score << ' ' << b->cash << '\n';
 
   for (const auto& move: b->getMoveset()) {
-    int s, d, dist;
-    std::tie(s, d, dist) = move;
-
-    cout << s << ',' << d << ' ';
+    cout << move.source() << ',' << move.dest() << ' ';
   }
   cout << '\n';
 
@@ -32,10 +29,11 @@ void report(const BoardPtr& b, const Tile& tile) {
 
 void bankerLoop(const bool interactive) {
   BoardPtr b = std::make_shared<Board>();
+  CounterRng rng(1, 0);
   int src, dst;
 
   while (true) {
-    const auto randomTile = b->getRandomTile(b->score);
+    const auto randomTile = b->getRandomTile(b->score, rng);
     int dist = 10;
 
     do {
@@ -44,8 +42,7 @@ void bankerLoop(const bool interactive) {
 
       b = b->move(src, dst, randomTile);
 
-      const int diff = abs(src-dst);
-      dist = diff/5 + diff%5;
+      dist = GEOMETRY.dist[src][dst];
     } while (dist > 1);
 
     if (b->isBankrupt()) {
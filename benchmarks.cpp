@@ -47,6 +47,64 @@ static void BM_jump(benchmark::State& state) {
 }
 BENCHMARK(BM_jump);
 
+static void BM_makeUnmakeMove(benchmark::State& state) {
+  auto b = setUp();
+  MoveUndo undo;
+
+  while (state.KeepRunning()) {
+    b->makeMove(10, 14, Tile(1, competitor), &undo);
+    b->unmakeMove(undo);
+    b->makeMove(12, 11, Tile(1), &undo);
+    b->unmakeMove(undo);
+  }
+}
+BENCHMARK(BM_makeUnmakeMove);
+
+static void BM_tickTimersScalar(benchmark::State& state) {
+  auto b = setUp();
+  uint8_t timers[Board::TIMER_LANES] = {0};
+  for (int i=0; i<BOARD_SIZE; i++) timers[i] = b->timer(i);
+
+  while (state.KeepRunning()) {
+    Board::tickTimersScalar(timers, b->board.typeMask(competitor));
+  }
+}
+BENCHMARK(BM_tickTimersScalar);
+
+static void BM_tickTimers(benchmark::State& state) {
+  auto b = setUp();
+  uint8_t timers[Board::TIMER_LANES] = {0};
+  for (int i=0; i<BOARD_SIZE; i++) timers[i] = b->timer(i);
+
+  while (state.KeepRunning()) {
+    Board::tickTimers(timers, b->board.typeMask(competitor));
+  }
+}
+BENCHMARK(BM_tickTimers);
+
+// Every cell a competitor: the worst case for the scalar loop
+static void BM_tickTimersScalarCrowded(benchmark::State& state) {
+  auto b = setUp();
+  uint8_t timers[Board::TIMER_LANES] = {0};
+  for (int i=0; i<BOARD_SIZE; i++) timers[i] = b->timer(i);
+
+  while (state.KeepRunning()) {
+    Board::tickTimersScalar(timers, Cells::ALL);
+  }
+}
+BENCHMARK(BM_tickTimersScalarCrowded);
+
+static void BM_tickTimersCrowded(benchmark::State& state) {
+  auto b = setUp();
+  uint8_t timers[Board::TIMER_LANES] = {0};
+  for (int i=0; i<BOARD_SIZE; i++) timers[i] = b->timer(i);
+
+  while (state.KeepRunning()) {
+    Board::tickTimers(timers, Cells::ALL);
+  }
+}
+BENCHMARK(BM_tickTimersCrowded);
+
 static void BM_competitorCosts(benchmark::State& state) {
   auto b = setUp();
 
@@ -4,12 +4,54 @@
 #include <ostream>
 #include <sstream>
 #include <string>
-#include <tuple>
-#include <vector>
+#include <unordered_set>
 
 #include "constants.h"
 #include "board.h"
 
+extern constexpr ZobristTable ZOBRIST = makeZobristTable();
+
+static_assert(PROBABILITY_INTERVALS == 6, "one sampler and outcome list per row of DISTRIBUTION");
+
+const AliasTable<TILE_TYPES> TILE_SAMPLERS[PROBABILITY_INTERVALS] = {
+  AliasTable<TILE_TYPES>(DISTRIBUTION[0]),
+  AliasTable<TILE_TYPES>(DISTRIBUTION[1]),
+  AliasTable<TILE_TYPES>(DISTRIBUTION[2]),
+  AliasTable<TILE_TYPES>(DISTRIBUTION[3]),
+  AliasTable<TILE_TYPES>(DISTRIBUTION[4]),
+  AliasTable<TILE_TYPES>(DISTRIBUTION[5]),
+};
+
+static TileOutcomes makeTileOutcomes(int row) {
+  TileOutcomes t;
+
+  for (int i=0; i<TILE_TYPES; i++) {
+    if (DISTRIBUTION[row][i] > 0) t.outcomes[t.count++] = {TILES[i], DISTRIBUTION[row][i]};
+  }
+
+  std::stable_sort(t.outcomes, t.outcomes + t.count, [](const TileOutcomes::Outcome& a, const TileOutcomes::Outcome& b) {
+    return a.probability > b.probability;
+  });
+
+  for (const auto& outcome : t) t.total += outcome.probability;
+
+  return t;
+}
+
+const TileOutcomes TILE_OUTCOMES[PROBABILITY_INTERVALS] = {
+  makeTileOutcomes(0),
+  makeTileOutcomes(1),
+  makeTileOutcomes(2),
+  makeTileOutcomes(3),
+  makeTileOutcomes(4),
+  makeTileOutcomes(5),
+};
+
+#if !defined(NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#define USE_SIMD
+#include <immintrin.h>
+#endif
+
 std::ostream& operator<<(std::ostream& os, const Board b) {
   for (int i=0; i<BOARD_SIZE; i++) {
     if (i != 0 && i % 5 == 0) {
@@ -17,7 +59,7 @@ std::ostream& operator<<(std::ostream& os, const Board b) {
     }
 
     if (b.bonus[i]) {
-      os << '$' << b.board[i].value;
+      os << '$' << b.board[i].value();
     } else {
       os << b.board[i];
     }
@@ -66,11 +108,11 @@ void Board::printCompetitorTimers() const {
 }
 
 bool Board::isEmpty(int position) const {
-  return board[position] == Tile();
+  return board.emptyMask() >> position & 1;
 }
 
 bool Board::isCompetitor(int position) const {
-  return board[position].tileType == competitor;
+  return board.typeMask(competitor) >> position & 1;
 }
 
 bool Board::isBankrupt() const {
@@ -78,63 +120,89 @@ bool Board::isBankrupt() const {
 }
 
 bool Board::isPosLawsuit(int pos) const {
-  return board[pos].tileType == positiveLawsuit;
+  return board.typeMask(positiveLawsuit) >> pos & 1;
 }
 
 bool Board::isNegLawsuit(int pos) const {
-  return board[pos].tileType == negativeLawsuit;
+  return board.typeMask(negativeLawsuit) >> pos & 1;
 }
 
 bool Board::isLawsuit(int pos) const {
-  return this->isPosLawsuit(pos) || this->isNegLawsuit(pos);
+  return this->lawsuitMask() >> pos & 1;
 }
 
 bool Board::isNonProfit(int pos) const {
-  return board[pos].tileType == nonProfit;
+  return board.typeMask(nonProfit) >> pos & 1;
+}
+
+uint32_t Board::lawsuitMask() const {
+  return board.typeMask(positiveLawsuit) | board.typeMask(negativeLawsuit);
 }
 
 int Board::numCompetitors() const {
-  return competitors;
+  return __builtin_popcount(board.typeMask(competitor));
 }
 
 int Board::competitorCosts() const {
-  int total = 0;
+  return board.competitorCosts();
+}
+
+uint64_t Board::hash() const {
+  const int distribRow = std::min(score/100, PROBABILITY_INTERVALS-1);
 
-  for (auto& tile: board) {
-    total += tile.tileType == competitor ? tile.value : 0;
+  return board.hash() ^ timerKey ^ bonus.hash() ^ ZOBRIST.band[distribRow];
+}
+
+uint64_t Board::stateKey() const {
+  uint64_t scalars = static_cast<uint16_t>(score) | static_cast<uint64_t>(static_cast<uint16_t>(cash)) << 16;
+
+  return this->hash() ^ splitmix64(&scalars);
+}
+
+uint64_t Board::recomputeHash() const {
+  uint64_t key = ZOBRIST.band[std::min(score/100, PROBABILITY_INTERVALS-1)];
+
+  for (int pos=0; pos<BOARD_SIZE; pos++) {
+    key ^= cellKey(pos, board[pos]);
+    key ^= ZOBRIST.timer[pos][competitorTimers[pos]];
+    key ^= ZOBRIST.bonus[pos][bonus[pos]];
   }
 
-  return total;
+  return key;
 }
 
-std::vector<std::tuple<int, int, int>> Board::getMoveset() const {
-  std::vector<std::tuple<int, int, int>> allPossibleMoves;
+MoveList Board::getMoveset() const {
+  MoveList allPossibleMoves;
 
-  for (int src=0; src<BOARD_SIZE; src++) {
-    if (this->isEmpty(src) || this->isNonProfit(src) || this->isCompetitor(src)) {
-      continue;
-    }
+  const uint32_t empty = board.emptyMask();
+  const uint32_t lawsuits = this->lawsuitMask();
+  const uint32_t blocked = board.typeMask(competitor) | board.typeMask(nonProfit);
+  const uint32_t sources = Cells::ALL & ~(empty | blocked);
 
-    for (const int& dest : possibleDest[src]) {
-      const int diff = abs(src-dest);
-      const int dist = diff/5 + diff%5;
+  for (uint32_t m = sources; m; m &= m - 1) {
+    const int src = __builtin_ctz(m);
+    const bool srcIsLawsuit = lawsuits >> src & 1;
+
+    for (const int& dest : GEOMETRY.dest[src]) {
+      const int dist = GEOMETRY.dist[src][dest];
+      const uint32_t destBit = 1u << dest;
 
       // If source is a lawsuit, it can only walk to an adjacent tile if it
       // isn't also a lawsuit
-      if (this->isLawsuit(src)) {
-        if (dist == 1 && !this->isEmpty(dest) && !this->isLawsuit(dest)) {
-          allPossibleMoves.push_back(std::make_tuple(src, dest, dist));
+      if (srcIsLawsuit) {
+        if (dist == 1 && !(destBit & (empty | lawsuits))) {
+          allPossibleMoves.push_back(Move(src, dest, dist));
         }
 
         continue;
       }
 
-      if (this->isCompetitor(dest) || this->isNonProfit(dest)) continue;
+      if (destBit & blocked) continue;
 
       if (board[src] == board[dest]) {
-        allPossibleMoves.push_back(std::make_tuple(src, dest, dist));
-      } else if (dist == 1 && (this->isEmpty(dest) || this->isLawsuit(dest))) {
-        allPossibleMoves.push_back(std::make_tuple(src, dest, dist));
+        allPossibleMoves.push_back(Move(src, dest, dist));
+      } else if (dist == 1 && (destBit & (empty | lawsuits))) {
+        allPossibleMoves.push_back(Move(src, dest, dist));
       }
     }
   }
@@ -142,68 +210,249 @@ std::vector<std::tuple<int, int, int>> Board::getMoveset() const {
   return allPossibleMoves;
 }
 
+// Extends turn, which ends in a jump or has no moves yet, by every move from
+// its board, until there are limit turns. jumped holds the boards after the
+// jumps searched so far, whose turns are all known already, and ended the
+// boards of the turns found.
+static void extendTurn(
+        const Tile& nextTile,
+        size_t limit,
+        Turn& turn,
+        std::unordered_set<uint64_t>& jumped,
+        std::unordered_set<uint64_t>& ended,
+        std::vector<Turn>& turns) {
+  const Board before = turn.board;
+  const MoveList moves = before.getMoveset();
+
+  if (moves.empty()) {
+    if (turn.count > 0 && ended.insert(before.stateKey()).second) turns.push_back(turn);
+    return;
+  }
+
+  for (const Move& m : moves) {
+    if (turns.size() >= limit) return;
+
+    MoveUndo undo;
+    turn.board.makeMove(m.source(), m.dest(), nextTile, &undo);
+    turn.moves[turn.count++] = m;
+
+    const uint64_t key = turn.board.stateKey();
+
+    if (!m.isJump()) {
+      if (ended.insert(key).second) turns.push_back(turn);
+    } else if (jumped.insert(key).second) {
+      extendTurn(nextTile, limit, turn, jumped, ended, turns);
+    }
+
+    turn.count--;
+    turn.board.unmakeMove(undo);
+  }
+}
+
+std::vector<Turn> Board::getTurns(const Tile& nextTile, size_t limit) const {
+  std::vector<Turn> turns;
+  std::unordered_set<uint64_t> jumped, ended;
+  Turn turn;
+
+  turn.board = *this;
+  extendTurn(nextTile, limit, turn, jumped, ended, turns);
+
+  return turns;
+}
+
 void Board::addCompetitor(int pos, Tile tile) {
   board[pos] = tile;
-  competitorTimers[pos] = 17;
-  competitors++;
+  this->setTimer(pos, 17);
 }
 
 void Board::clearCompetitor(int pos) {
   board[pos] = Tile();
-  competitorTimers[pos] = 0;
-  competitors--;
+  this->setTimer(pos, 0);
+}
+
+void Board::setTimer(int pos, int value) {
+  timerKey ^= ZOBRIST.timer[pos][competitorTimers[pos]] ^ ZOBRIST.timer[pos][value];
+  competitorTimers[pos] = value;
 }
 
 void Board::addBonus(int pos, int value) {
-  bonus[pos] = value;
+  bonus.set(pos, value);
 }
 
-void Board::updateTimer() {
-  for (int i=0; i<BOARD_SIZE; i++) {
-    if (!this->isCompetitor(i)) continue;
+void Bonuses::set(int pos, int value) {
+  key ^= ZOBRIST.bonus[pos][values[pos]] ^ ZOBRIST.bonus[pos][value];
+  values[pos] = value;
+}
+
+int Bonuses::maxValue() const {
+  int maxValue = 0;
+  for (int pos=0; pos<BOARD_SIZE; pos++) {
+    if (values[pos] > maxValue) maxValue = values[pos];
+  }
+
+  return maxValue;
+}
+
+void Bonuses::tick() {
+  static_assert(LANES == 32, "bonuses are ticked as two 16-byte vectors");
+
+#ifdef USE_SIMD
+  __m128i* p = reinterpret_cast<__m128i*>(values);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i low = _mm_loadu_si128(p);
+  const __m128i high = _mm_loadu_si128(p + 1);
+
+  const uint32_t idle = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, zero))) |
+                        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, zero))) << 16;
+  const uint32_t active = ~idle;
 
-    if (!competitorTimers[i]) {
-      board[i] = Tile(board[i].value + 1, competitor);
-      competitorTimers[i] = 18;
+  if (!active) return;
+
+  const __m128i one = _mm_set1_epi8(1);
+  _mm_storeu_si128(p, _mm_subs_epu8(low, one));
+  _mm_storeu_si128(p + 1, _mm_subs_epu8(high, one));
+
+  for (uint32_t m = active; m; m &= m - 1) {
+    const int pos = __builtin_ctz(m);
+    key ^= ZOBRIST.bonus[pos][values[pos] + 1] ^ ZOBRIST.bonus[pos][values[pos]];
+  }
+#else
+  for (int pos=0; pos<BOARD_SIZE; pos++) {
+    if (values[pos]) {
+      key ^= ZOBRIST.bonus[pos][values[pos]] ^ ZOBRIST.bonus[pos][values[pos] - 1];
+      values[pos]--;
+    }
+  }
+#endif
+}
+
+uint32_t Board::tickTimersScalar(uint8_t timers[], uint32_t competitors) {
+  uint32_t expired = 0;
+
+  for (uint32_t m = competitors; m; m &= m - 1) {
+    const int i = __builtin_ctz(m);
+
+    if (!timers[i]) {
+      timers[i] = 18;
+      expired |= 1u << i;
       continue;
     }
 
-    competitorTimers[i]--;
+    timers[i]--;
   }
+
+  return expired;
 }
 
-void Board::updateBonus() {
-  for (int i=0; i<BOARD_SIZE; i++) {
-    if (bonus[i]) bonus[i]--;
+#ifdef USE_SIMD
+// Byte k of the result is all ones if bit k of mask is set
+static inline __m128i expandMask(uint32_t mask) {
+  // Spread in unsigned arithmetic; a byte of 0x80 or more overflows int64_t
+  const uint64_t high = 0x0101010101010101ULL * (mask >> 8 & 0xff);
+  const uint64_t low = 0x0101010101010101ULL * (mask & 0xff);
+
+  const __m128i bits = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+  const __m128i bytes = _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+
+  return _mm_cmpeq_epi8(_mm_and_si128(bytes, bits), bits);
+}
+#endif
+
+uint32_t Board::tickTimers(uint8_t timers[], uint32_t competitors) {
+#if defined(USE_SIMD) && defined(__AVX2__)
+  __m256i* p = reinterpret_cast<__m256i*>(timers);
+
+  const __m256i t = _mm256_loadu_si256(p);
+  const __m256i isCompetitor = _mm256_set_m128i(expandMask(competitors >> 16), expandMask(competitors));
+  const __m256i isExpired = _mm256_and_si256(isCompetitor, _mm256_cmpeq_epi8(t, _mm256_setzero_si256()));
+
+  // Competitors count down, expired ones restart at 18, everything else stays
+  __m256i next = _mm256_add_epi8(t, isCompetitor);
+  next = _mm256_blendv_epi8(next, _mm256_set1_epi8(18), isExpired);
+
+  _mm256_storeu_si256(p, next);
+
+  return static_cast<uint32_t>(_mm256_movemask_epi8(isExpired));
+#elif defined(USE_SIMD)
+  uint32_t expired = 0;
+
+  for (int half=0; half<2; half++) {
+    __m128i* p = reinterpret_cast<__m128i*>(timers) + half;
+
+    const __m128i t = _mm_loadu_si128(p);
+    const __m128i isCompetitor = expandMask(competitors >> (16 * half));
+    const __m128i isExpired = _mm_and_si128(isCompetitor, _mm_cmpeq_epi8(t, _mm_setzero_si128()));
+
+    // Competitors count down, expired ones restart at 18, everything else stays
+    __m128i next = _mm_add_epi8(t, isCompetitor);
+    next = _mm_or_si128(_mm_andnot_si128(isExpired, next), _mm_and_si128(isExpired, _mm_set1_epi8(18)));
+
+    _mm_storeu_si128(p, next);
+    expired |= static_cast<uint32_t>(_mm_movemask_epi8(isExpired)) << (16 * half);
   }
+
+  return expired;
+#else
+  return tickTimersScalar(timers, competitors);
+#endif
 }
 
-BoardPtr Board::walk(
+// Returns a bitmask of the competitors whose timer ran out and were upgraded,
+// and sets expired to those whose timer ran out
+int Board::updateTimer(uint32_t* expired) {
+  int upgraded = 0;
+  const uint32_t competitors = board.typeMask(competitor);
+
+  for (uint32_t m = competitors; m; m &= m - 1) {
+    const int i = __builtin_ctz(m);
+    const int next = competitorTimers[i] ? competitorTimers[i] - 1 : 18;
+
+    timerKey ^= ZOBRIST.timer[i][competitorTimers[i]] ^ ZOBRIST.timer[i][next];
+  }
+
+  *expired = tickTimers(competitorTimers, competitors);
+
+  for (uint32_t m = *expired; m; m &= m - 1) {
+    const int i = __builtin_ctz(m);
+
+    // A saturated competitor keeps its value
+    if (board[i].value() < PackedTile::MAX_VALUE) {
+      board[i] = Tile(board[i].value() + 1, competitor);
+      upgraded |= 1 << i;
+    }
+  }
+
+  return upgraded;
+}
+
+void Board::updateBonus() {
+  bonus.tick();
+}
+
+void Board::walk(
         const int source,
         const int dest,
-        const Tile& nextTile) const {
-  const int sourceTile = this->board[source].value;
-  const int destTile = this->board[dest].value;
-
-   BoardPtr newBoard = std::make_shared<Board>(*this);
+        const Tile& nextTile) {
+  const int sourceTile = this->board[source].value();
+  const int destTile = this->board[dest].value();
 
   // Moving lawsuit directly does not change cash or score
   if (this->isLawsuit(source)) {
-    auto oldTile = newBoard->board[dest];
+    const PackedTile oldTile = board[dest];
 
     if (this->isNegLawsuit(source)) {
-      newBoard->board[dest] = Tile(oldTile.value - 1, oldTile.tileType);
+      board[dest] = Tile(oldTile.value() - 1, oldTile.tileType());
     } else {
-      newBoard->board[dest] = Tile(oldTile.value + 1, oldTile.tileType);
+      board[dest] = Tile(oldTile.value() + 1, oldTile.tileType());
     }
 
-    if (newBoard->isCompetitor(dest) && newBoard->board[dest].value < 0) {
-      newBoard->clearCompetitor(dest);
+    if (this->isCompetitor(dest) && board[dest].value() < 0) {
+      this->clearCompetitor(dest);
     }
 
-    newBoard->board[source] = Tile();
+    board[source] = Tile();
 
-    return newBoard;
+    return;
   }
 
   int newDest, cashDelta, scoreDelta;
@@ -214,7 +463,7 @@ BoardPtr Board::walk(
     scoreDelta = newDest;
   } else {
 
-    switch (board[dest].tileType) {
+    switch (board[dest].tileType()) {
       case negativeLawsuit:
         newDest = sourceTile - 1;
         break;
@@ -225,13 +474,13 @@ BoardPtr Board::walk(
         newDest = sourceTile;
     }
 
-    const auto bonusValue = newBoard->bonus[dest];
+    const auto bonusValue = bonus[dest];
 
     if (bonusValue) {
       cashDelta = bonusValue;
       scoreDelta = bonusValue;
-      newBoard->bonus[dest] = 0;
-    } else if (newBoard->isLawsuit(dest)) {
+      bonus.set(dest, 0);
+    } else if (this->isLawsuit(dest)) {
       cashDelta = 0;
       scoreDelta = 0;
     } else {
@@ -241,116 +490,151 @@ BoardPtr Board::walk(
   }
 
   // Competitor costs must be calculated before adding the new competitor
-  newBoard->cash += cashDelta;
-  newBoard->cash -= newBoard->competitorCosts();
+  cash += cashDelta;
+  cash -= this->competitorCosts();
 
   if (nextTile.tileType == competitor) {
-    newBoard->addCompetitor(source, nextTile);
+    this->addCompetitor(source, nextTile);
   } else {
-    newBoard->board[source] = nextTile;
+    board[source] = nextTile;
   }
 
-  newBoard->board[dest] = Tile(newDest);
-  newBoard->score += scoreDelta;
-
-  return newBoard;
+  board[dest] = Tile(newDest);
+  score += scoreDelta;
 }
 
-BoardPtr Board::jump(
+void Board::jump(
         const int source,
         const int dest,
-        const Tile& nextTile,
-        const int start,
-        const int dist,
-        const bool horizontalMove) const {
-  const int sourceTile = this->board[source].value;
-
-  BoardPtr newBoard = std::make_shared<Board>(*this);
+        const Tile& nextTile) {
+  const int sourceTile = this->board[source].value();
 
-  newBoard->board[source] = Tile();
-  newBoard->board[dest] = Tile(sourceTile + 1);
-  newBoard->cash += sourceTile + 1;
-  newBoard->score += sourceTile + 1;
+  board[source] = Tile();
+  board[dest] = Tile(sourceTile + 1);
+  cash += sourceTile + 1;
+  score += sourceTile + 1;
 
-  int destroyedTiles = 0;
-  for (int i=1; i<dist; i++) {
-    const int pos = horizontalMove ? start + i : (start + i*5);
-    const int val = newBoard->board[pos].value;
+  // Competitors and nonProfits smaller than the jumping tile are destroyed
+  uint32_t destroyed = 0;
+  const uint32_t path = GEOMETRY.path[source][dest];
 
-    if (!newBoard->isCompetitor(pos) && !newBoard->isNonProfit(pos)) continue;
+  for (uint32_t m = path & (board.typeMask(competitor) | board.typeMask(nonProfit)); m; m &= m - 1) {
+    const int pos = __builtin_ctz(m);
 
-    if (sourceTile > val) {
-      if (newBoard->isCompetitor(pos)) newBoard->clearCompetitor(pos);
-      else newBoard->board[pos] = Tile();
+    if (sourceTile > board[pos].value()) destroyed |= 1u << pos;
+  }
 
-      destroyedTiles++;
-    }
+  board.clear(destroyed);
+  for (uint32_t m = destroyed; m; m &= m - 1) {
+    this->setTimer(__builtin_ctz(m), 0);
   }
 
+  const int destroyedTiles = __builtin_popcount(destroyed);
+
   if (destroyedTiles > 1) {
     const int comboBonus = 1 << destroyedTiles;
-    newBoard->score += comboBonus;
-    newBoard->cash += comboBonus;
+    score += comboBonus;
+    cash += comboBonus;
   }
 
   // Competitor costs must come after competitors are eliminated
-  newBoard->cash -= newBoard->competitorCosts();
+  cash -= this->competitorCosts();
+}
 
-  return newBoard;
+void Board::saveCell(MoveUndo* undo, const int pos) const {
+  const int i = undo->numCells++;
+
+  undo->pos[i] = pos;
+  undo->tile[i] = board[pos];
+  undo->timer[i] = competitorTimers[pos];
 }
 
-BoardPtr Board::move(
+void Board::makeMove(
         const int source,
         const int dest,
-        const Tile& nextTile) {
-  int start, dist;
+        const Tile& nextTile,
+        MoveUndo* undo) {
+  undo->numCells = 0;
+  undo->bonus = bonus;
+  undo->score = score;
+  undo->cash = cash;
+  undo->timerKey = timerKey;
+
+  this->saveCell(undo, source);
+  this->saveCell(undo, dest);
+
+  if (GEOMETRY.dist[source][dest] == 1) {
+    this->walk(source, dest, nextTile);
+  } else {
+    for (uint32_t m = GEOMETRY.path[source][dest]; m; m &= m - 1) {
+      this->saveCell(undo, __builtin_ctz(m));
+    }
 
-  const int x1 = source % 5;
-  const int y1 = source / 5;
-  const int x2 = dest % 5;
-  const int y2 = dest / 5;
+    this->jump(source, dest, nextTile);
+  }
+
+  this->updateBonus();
+  undo->competitorsUpgraded = this->updateTimer(&undo->timersExpired);
+}
 
-  bool horizontalMove = y1 == y2;
+void Board::unmakeMove(const MoveUndo& undo) {
+  // Reverse the end-of-move bookkeeping first, it ran on the moved board
+  for (uint32_t m = board.typeMask(competitor); m; m &= m - 1) {
+    const int i = __builtin_ctz(m);
 
-  if (horizontalMove) {
-    start = x1 < x2 ? source : dest;
-    dist = abs(x1 - x2);
-  } else {
-    start = y1 < y2 ? source : dest;
-    dist = abs(y1 - y2);
+    if (undo.timersExpired & (1u << i)) {
+      if (undo.competitorsUpgraded & (1 << i)) board[i] = Tile(board[i].value() - 1, competitor);
+      competitorTimers[i] = 0;
+    } else {
+      competitorTimers[i]++;
+    }
   }
 
-  auto newBoard = (dist == 1) ? \
-                    this->walk(source, dest, nextTile) : \
-                    this->jump(source, dest, nextTile, start, dist, horizontalMove);
+  for (int i=undo.numCells-1; i>=0; i--) {
+    const int pos = undo.pos[i];
 
-  newBoard->updateBonus();
-  newBoard->updateTimer();
+    board[pos] = undo.tile[i];
+    competitorTimers[pos] = undo.timer[i];
+  }
 
-  return newBoard;
+  bonus = undo.bonus;
+  score = undo.score;
+  cash = undo.cash;
+  timerKey = undo.timerKey;
 }
 
-const Tile Board::getRandomTile(int score) {
-  using std::cout;
+BoardPtr Board::move(
+        const int source,
+        const int dest,
+        const Tile& nextTile) {
+  MoveUndo undo;
 
-  float p = (rand()/static_cast<float>(RAND_MAX));
+  BoardPtr newBoard = std::make_shared<Board>(*this);
+  newBoard->makeMove(source, dest, nextTile, &undo);
 
-  const int distribRow = std::min(score/100, PROBABILITY_INTERVALS-1);
-  int tileIndex = 0;
+  return newBoard;
+}
 
-  while (true) {
-    p -= DISTRIBUTION[distribRow][tileIndex];
-    if (p > 0) tileIndex++;
-    else break;
+bool Board::operator==(const Board& b) const {
+  for (int i=0; i<BOARD_SIZE; i++) {
+    if (board[i] != b.board[i]) return false;
+    if (competitorTimers[i] != b.competitorTimers[i]) return false;
+    if (bonus[i] != b.bonus[i]) return false;
   }
 
-  if (tileIndex >= TILE_TYPES) {
-#ifdef DEBUG
-    cout << "DEBUG: tileIndex = " << tileIndex << '\n';
-#endif
-    return Tile(1);
-  }
+  return score == b.score && cash == b.cash;
+}
+
+bool Board::operator!=(const Board& b) const {
+  return !(*this == b);
+}
+
+const Tile Board::getRandomTile(int score, CounterRng& rng) {
+  return Board::getRandomTile(score, rng.next());
+}
 
-  return TILES[tileIndex];
+const Tile Board::getRandomTile(int score, uint64_t draw) {
+  const int distribRow = std::min(score/100, PROBABILITY_INTERVALS-1);
+  return TILES[TILE_SAMPLERS[distribRow].sample(draw)];
 }
 
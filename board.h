@@ -1,30 +1,264 @@
 #ifndef __BOARD_H__
 #define __BOARD_H__
 
-#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
 #include <ostream>
-#include <tuple>
 #include <vector>
 
+#include "alias.h"
 #include "constants.h"
+#include "move.h"
+#include "rng.h"
 #include "tile.h"
+#include "zobrist.h"
 
 class Board;
+struct Turn;
 
 typedef std::shared_ptr<Board> BoardPtr;
 
+// The tiles of a row of DISTRIBUTION with nonzero probability, most likely
+// first, and their summed probability
+struct TileOutcomes {
+  struct Outcome {
+    Tile tile;
+    float probability;
+  };
+
+  Outcome outcomes[TILE_TYPES];
+  int count = 0;
+  float total = 0.0;
+
+  const Outcome* begin() const {
+    return outcomes;
+  }
+
+  const Outcome* end() const {
+    return outcomes + count;
+  }
+};
+
+// Samplers and outcome lists for the rows of DISTRIBUTION, defined in
+// board.cpp
+extern const AliasTable<TILE_TYPES> TILE_SAMPLERS[PROBABILITY_INTERVALS];
+extern const TileOutcomes TILE_OUTCOMES[PROBABILITY_INTERVALS];
+
+// A byte of remaining cash bonus per cell, 0 for none. The counters are
+// padded to LANES bytes so tick() can count them all down as vectors; the
+// padding stays zero.
+class Bonuses {
+  public:
+    static const int LANES = 32;
+    static const int MAX_VALUE = UINT8_MAX;
+
+    int operator[](int pos) const {
+      return values[pos];
+    }
+
+    // value must lie in [0, MAX_VALUE]
+    void set(int pos, int value);
+    void tick();
+    int maxValue() const;
+
+    // Zobrist key of the active bonuses
+    uint64_t hash() const {
+      return key;
+    }
+
+  private:
+    uint8_t values[LANES] = {0};
+    uint64_t key = 0;
+};
+
+// The tiles of a board: a signed value byte per position and a 25-bit mask
+// of the positions holding each tile type, which is where a tile's type is
+// kept, and of the empty positions, along with the running total of the
+// competitors' values and the Zobrist key of the tiles. Writes go through
+// Ref, which keeps all of them in step with the tiles.
+class Cells {
+  public:
+    class Ref {
+      public:
+        Ref(Cells* cells, int pos)
+            : cells(cells), pos(pos) {}
+
+        Ref& operator=(const PackedTile& t) {
+          cells->set(pos, t);
+          return *this;
+        }
+
+        Ref& operator=(const Ref& r) {
+          return *this = PackedTile(r);
+        }
+
+        operator PackedTile() const {
+          return cells->get(pos);
+        }
+
+        int value() const {
+          return cells->values[pos];
+        }
+
+        TileType tileType() const {
+          return cells->tileType(pos);
+        }
+
+        bool operator==(const PackedTile& t) const {
+          return cells->get(pos) == t;
+        }
+
+        bool operator!=(const PackedTile& t) const {
+          return cells->get(pos) != t;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Ref& r) {
+          return os << PackedTile(r);
+        }
+
+      private:
+        Cells* cells;
+        int pos;
+    };
+
+    static const uint32_t ALL = (1u << BOARD_SIZE) - 1;
+
+    Cells(std::initializer_list<PackedTile> init) {
+      empty = ALL;
+      costs = 0;
+      key = 0;
+
+      for (auto& mask : masks) mask = 0;
+      masks[regular] = ALL;
+
+      for (int pos=0; pos<BOARD_SIZE; pos++) {
+        values[pos] = 0;
+        key ^= cellKey(pos, PackedTile());
+      }
+
+      int pos = 0;
+      for (const auto& t : init) {
+        this->set(pos, t);
+        pos++;
+      }
+    }
+
+    PackedTile operator[](int pos) const {
+      return this->get(pos);
+    }
+
+    Ref operator[](int pos) {
+      return Ref(this, pos);
+    }
+
+    uint32_t typeMask(TileType tileType) const {
+      return masks[tileType];
+    }
+
+    uint32_t emptyMask() const {
+      return empty;
+    }
+
+    int competitorCosts() const {
+      return costs;
+    }
+
+    uint64_t hash() const {
+      return key;
+    }
+
+    // Empties every position in mask
+    void clear(uint32_t mask) {
+      for (uint32_t m = mask; m; m &= m - 1) {
+        const int pos = __builtin_ctz(m);
+
+        key ^= cellKey(pos, this->get(pos)) ^ cellKey(pos, PackedTile());
+        if (masks[competitor] >> pos & 1) costs -= values[pos];
+        values[pos] = 0;
+      }
+
+      for (auto& m : masks) m &= ~mask;
+      masks[regular] |= mask;
+      empty |= mask;
+    }
+
+    void set(int pos, PackedTile t) {
+      const uint32_t bit = 1u << pos;
+      const TileType oldType = this->tileType(pos);
+
+      if (oldType == competitor) costs -= values[pos];
+      if (t.tileType() == competitor) costs += t.value();
+
+      masks[oldType] &= ~bit;
+      masks[t.tileType()] |= bit;
+
+      if (t == PackedTile()) empty |= bit;
+      else empty &= ~bit;
+
+      key ^= cellKey(pos, PackedTile(values[pos], oldType)) ^ cellKey(pos, t);
+      values[pos] = t.value();
+    }
+
+  private:
+    static const int NUM_TYPES = competitor + 1;
+
+    int8_t values[BOARD_SIZE];
+    uint32_t masks[NUM_TYPES];
+    uint32_t empty;
+    int16_t costs;
+    uint64_t key;
+
+    // Every position is in exactly one mask, empty ones in the regular one
+    TileType tileType(int pos) const {
+      for (int t=regular+1; t<NUM_TYPES; t++) {
+        if (masks[t] >> pos & 1) return static_cast<TileType>(t);
+      }
+
+      return regular;
+    }
+
+    PackedTile get(int pos) const {
+      return PackedTile(values[pos], this->tileType(pos));
+    }
+};
+
+// Records everything Board::makeMove changes so that Board::unmakeMove can
+// restore the board exactly. A move touches at most the source, the dest and
+// the three tiles a jump passes over.
+struct MoveUndo {
+  static const int MAX_CELLS = 5;
+
+  int numCells = 0;
+  uint8_t pos[MAX_CELLS];
+  PackedTile tile[MAX_CELLS];
+  uint8_t timer[MAX_CELLS];
+
+  Bonuses bonus;
+  int16_t score;
+  int16_t cash;
+  uint64_t timerKey;
+
+  // Bitmasks of the competitors whose timer ran out at the end of the move,
+  // and of those of them that were upgraded; a saturated one is not
+  uint32_t timersExpired;
+  int competitorsUpgraded;
+};
+
+// Board fits in three 64-byte cache lines: the tile values with their
+// tile-class masks, the competitor timers and the bonus counters.
 class Board {
   public:
-    std::array<Tile, BOARD_SIZE> board = {Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
-                                          Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
-                                          Tile(0), Tile(0), Tile(1), Tile(0), Tile(0),
-                                          Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
-                                          Tile(0), Tile(0), Tile(0), Tile(0), Tile(0)};
-    int competitorTimers[BOARD_SIZE] = {0};
-    int bonus[BOARD_SIZE] = {0};
-    int score = 10;
-    int cash = 10;
+    Cells board = {Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
+                   Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
+                   Tile(0), Tile(0), Tile(1), Tile(0), Tile(0),
+                   Tile(0), Tile(0), Tile(0), Tile(0), Tile(0),
+                   Tile(0), Tile(0), Tile(0), Tile(0), Tile(0)};
+    static const int TIMER_LANES = 32;
+    Bonuses bonus;
+    int16_t score = 10;
+    int16_t cash = 10;
 
     // ----- Methods ----------
     // Util methods
@@ -35,13 +269,46 @@ class Board {
     bool isNegLawsuit(int position) const;
     bool isNonProfit(int position) const;
     bool isCompetitor(int position) const;
+    uint32_t lawsuitMask() const;
     int numCompetitors() const;
     bool isBankrupt() const;
     int competitorCosts() const;
-    std::vector<std::tuple<int, int, int>> getMoveset() const;
+    MoveList getMoveset() const;
+
+    // The ways to play nextTile as a whole turn: jumps with the same tile up
+    // to a move that is not one. Turns that end in the same board as an
+    // earlier one are left out, so each end state appears once. Chains of
+    // jumps multiply quickly, so generation stops after limit turns.
+    std::vector<Turn> getTurns(const Tile& nextTile, size_t limit) const;
+
+    // 64-bit Zobrist key of the tiles, competitor timers, bonuses and score
+    // band, kept up to date as the board changes. recomputeHash() derives
+    // the same key from scratch.
+    uint64_t hash() const;
+    uint64_t recomputeHash() const;
+
+    // hash() with the exact score and cash as well as their band, so equal
+    // keys mean boards that play the same
+    uint64_t stateKey() const;
 
     static void printMove(const int source, const int dest);
-    static const Tile getRandomTile(int score);
+    static const Tile getRandomTile(int score, CounterRng& rng);
+    static const Tile getRandomTile(int score, uint64_t draw);
+
+    // Counts down the timers of the competitors in the given mask, resetting
+    // the ones that have run out to 18, and returns a bitmask of those.
+    // timers must hold TIMER_LANES bytes. tickTimers uses SSE2/AVX2 when built
+    // with them; tickTimersScalar is the portable version.
+    static uint32_t tickTimers(uint8_t timers[], uint32_t competitors);
+    static uint32_t tickTimersScalar(uint8_t timers[], uint32_t competitors);
+
+    // Moves left before the competitor at pos is upgraded. setTimer keeps
+    // the Zobrist key in step, which is why the timers are private.
+    int timer(int pos) const {
+      return competitorTimers[pos];
+    }
+
+    void setTimer(int pos, int value);
 
     // Board modifying methods
     void addCompetitor(int pos, Tile tile);
@@ -49,15 +316,43 @@ class Board {
     void addBonus(int pos, int value);
     BoardPtr move(const int source, const int dest, const Tile& nextTile);
 
+    // In-place variant of move() for the search: applies the move to this
+    // board and records how to take it back in undo.
+    void makeMove(const int source, const int dest, const Tile& nextTile, MoveUndo* undo);
+    void unmakeMove(const MoveUndo& undo);
+
+    bool operator==(const Board& b) const;
+    bool operator!=(const Board& b) const;
+
     friend std::ostream& operator<<(std::ostream& os, const Board b);
 
   private:
-    int competitors = 0;
+    // Padded to a full 32-byte vector for tickTimers; the padding stays zero
+    uint8_t competitorTimers[TIMER_LANES] = {0};
+    uint64_t timerKey = 0;
 
-    void updateTimer();
+    int updateTimer(uint32_t* expired);
     void updateBonus();
-    BoardPtr walk(const int source, const int dest, const Tile& nextTile) const;
-    BoardPtr jump(const int source, const int dest, const Tile& nextTile, const int start, const int dist, const bool horizontalJump) const;
+    void saveCell(MoveUndo* undo, const int pos) const;
+    void walk(const int source, const int dest, const Tile& nextTile);
+    void jump(const int source, const int dest, const Tile& nextTile);
+};
+
+static_assert(sizeof(Board) <= 192, "Board must fit in three cache lines");
+
+// The moves of a whole turn and the board they leave. Every jump but the last
+// move merges two tiles into one, so a turn has at most a move per cell. A
+// jump with no move after it ends the turn too.
+struct Turn {
+  static const int MAX_MOVES = BOARD_SIZE;
+
+  Move moves[MAX_MOVES];
+  int count = 0;
+  Board board;
+
+  const Move& last() const {
+    return moves[count - 1];
+  }
 };
 
 #endif
@@ -0,0 +1,29 @@
+#include "budget.h"
+
+SearchBudget::SearchBudget(int timeMs, unsigned long maxNodes)
+    : deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeMs)),
+      hasDeadline(timeMs > 0),
+      maxNodes(maxNodes),
+      spent(0),
+      stopped(false) {}
+
+bool SearchBudget::spend() {
+  const unsigned long n = spent.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  if (maxNodes && n >= maxNodes) this->stop();
+  if (hasDeadline && n % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline) this->stop();
+
+  return this->exhausted();
+}
+
+bool SearchBudget::exhausted() const {
+  return stopped.load(std::memory_order_relaxed);
+}
+
+void SearchBudget::stop() {
+  stopped.store(true, std::memory_order_relaxed);
+}
+
+unsigned long SearchBudget::nodes() const {
+  return spent.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+#ifndef __BUDGET_H__
+#define __BUDGET_H__
+
+#include <atomic>
+#include <chrono>
+
+// Time and node limits on a search, shared by all of its threads. Once
+// either runs out, or stop is called, the search unwinds and its result is
+// thrown away. A limit of 0 is no limit.
+class SearchBudget {
+  public:
+    SearchBudget(int timeMs, unsigned long maxNodes);
+
+    // Counts a node; returns whether the budget is spent
+    bool spend();
+
+    bool exhausted() const;
+    void stop();
+
+    unsigned long nodes() const;
+
+  private:
+    // Nodes between looks at the clock
+    static const unsigned long CLOCK_INTERVAL = 256;
+
+    const std::chrono::steady_clock::time_point deadline;
+    const bool hasDeadline;
+    const unsigned long maxNodes;
+
+    std::atomic<unsigned long> spent;
+    std::atomic<bool> stopped;
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef __CONSTANTS_H__
 #define __CONSTANTS_H__
 
+#include <cstdint>
+
 #include "tile.h"
 
 const int BOARD_SIZE = 25;
@@ -17,34 +19,55 @@ const int CORNERS[NUM_CORNERS] = {0, 4, 20, 24};
 const int EDGES[NUM_EDGES] = {1, 2, 3, 5, 9, 10, 14, 15, 19, 21, 22, 23};
 const int CENTERS[NUM_CENTERS] = {6, 7, 8, 11, 12, 13, 16, 17, 18};
 
-const int possibleDest[BOARD_SIZE][8] = {
-  {1, 2, 3, 4, 5, 10, 15, 20}, // 0
-  {0, 2, 3, 4, 6, 11, 16, 21}, // 1
-  {0, 1, 3, 4, 7, 12, 17, 22}, // 2
-  {0, 1, 2, 4, 8, 13, 18, 23}, // 3
-  {0, 1, 2, 3, 9, 14, 19, 24}, // 4
-  {0, 6, 7, 8, 9, 10, 15, 20}, // 5
-  {1, 5, 7, 8, 9, 11, 16, 21}, // 6
-  {2, 5, 6, 8, 9, 12, 17, 22}, // 7
-  {3, 5, 6, 7, 9, 13, 18, 23}, // 8
-  {4, 5, 6, 7, 8, 14, 19, 24}, // 9
-  {0, 5, 11, 12, 13, 14, 15, 20}, // 10
-  {1, 6, 10, 12, 13, 14, 16, 21}, // 11
-  {2, 7, 10, 11, 13, 14, 17, 22}, // 12
-  {3, 8, 10, 11, 12, 14, 18, 23}, // 13
-  {4, 9, 10, 11, 12, 13, 19, 24}, // 14
-  {0, 5, 10, 16, 17, 18, 19, 20}, // 15
-  {1, 6, 11, 15, 17, 18, 19, 21}, // 16
-  {2, 7, 12, 15, 16, 18, 19, 22}, // 17
-  {3, 8, 13, 15, 16, 17, 19, 23}, // 18
-  {4, 9, 14, 15, 16, 17, 18, 24}, // 19
-  {0, 5, 10, 15, 21, 22, 23, 24}, // 20
-  {1, 6, 11, 16, 20, 22, 23, 24}, // 21
-  {2, 7, 12, 17, 20, 21, 23, 24}, // 22
-  {3, 8, 13, 18, 20, 21, 22, 24}, // 23
-  {4, 9, 14, 19, 20, 21, 22, 23}  // 24
+const int BOARD_WIDTH = 5;
+const int MAX_DESTS = 8;
+
+// Geometry of every (source, dest) pair, generated at compile time. A tile
+// can only move along its row or column; pairs that are not in line have a
+// distance of 0.
+struct MoveGeometry {
+  int dest[BOARD_SIZE][MAX_DESTS];
+  int dist[BOARD_SIZE][BOARD_SIZE];
+
+  // Bitmask of the positions strictly between source and dest
+  uint32_t path[BOARD_SIZE][BOARD_SIZE];
 };
 
+constexpr MoveGeometry makeMoveGeometry() {
+  MoveGeometry g {};
+
+  for (int src=0; src<BOARD_SIZE; src++) {
+    int numDests = 0;
+
+    for (int dest=0; dest<BOARD_SIZE; dest++) {
+      const int x1 = src % BOARD_WIDTH;
+      const int y1 = src / BOARD_WIDTH;
+      const int x2 = dest % BOARD_WIDTH;
+      const int y2 = dest / BOARD_WIDTH;
+
+      if (src == dest || (x1 != x2 && y1 != y2)) continue;
+
+      const bool horizontal = y1 == y2;
+      const int dist = horizontal ? (x1 < x2 ? x2 - x1 : x1 - x2) : (y1 < y2 ? y2 - y1 : y1 - y2);
+      const int step = horizontal ? 1 : BOARD_WIDTH;
+      const int start = src < dest ? src : dest;
+
+      uint32_t path = 0;
+      for (int i=1; i<dist; i++) {
+        path |= 1u << (start + i*step);
+      }
+
+      g.dest[src][numDests++] = dest;
+      g.dist[src][dest] = dist;
+      g.path[src][dest] = path;
+    }
+  }
+
+  return g;
+}
+
+constexpr MoveGeometry GEOMETRY = makeMoveGeometry();
+
 const int PROBABILITY_INTERVALS = 6;
 const int TILE_TYPES = 10;
 const Tile TILES[TILE_TYPES] = {
@@ -1,30 +1,53 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
-#include <tuple>
-#include <vector>
+#include <thread>
+#include <utility>
 
 #include <time.h>
 #include <stdlib.h>
 
 #include "constants.h"
 #include "emm.h"
+#include "ponder.h"
 #include "tile.h"
 
-// Cache for reused heuristic values
-typedef std::map<int, int> HeuristicCache;
-static HeuristicCache hc;
+SearchContext SearchContext::fork() const {
+  SearchContext context;
 
-int hashBoard(const Board &b) {
-  int h = BOARD_SIZE;
-  for (int i=0; i<BOARD_SIZE; i++) {
-    h = h * 17 + b.board[i].value;
-  }
+  context.countLeafNodes = countLeafNodes;
+  context.scheduler = scheduler;
+  context.splitDepth = splitDepth;
+  context.pruneThreshold = pruneThreshold;
+  context.budget = budget;
+  context.wholeTurns = wholeTurns;
+
+  return context;
+}
+
+void SearchContext::merge(const SearchContext& context) {
+  leafNodesExplored += context.leafNodesExplored;
+  ttProbes += context.ttProbes;
+  ttHits += context.ttHits;
+  duplicateSuccessors += context.duplicateSuccessors;
+  prunedChildren += context.prunedChildren;
+  errorBound += context.errorBound;
+}
+
+bool SearchContext::splits(int depth) const {
+  return scheduler && depth >= splitDepth;
+}
 
-  return h;
+bool SearchContext::stopped() const {
+  return budget && budget->exhausted();
 }
 
 BoardPtr EMM::solveBestMove(
@@ -32,40 +55,206 @@ BoardPtr EMM::solveBestMove(
         const Tile& nextTile,
         int depth,
         int* dist,
-        bool verbose) {
+        bool verbose,
+        SearchContext* context) {
   using std::cout;
 
-  clock_t t = clock();  // Start recording
+  const auto start = std::chrono::steady_clock::now();  // Start recording
+
+  tt.newSearch();
+
+  // The search makes and unmakes moves on its own copy of the board
+  alignas(64) Board board = *b;
+
+  const float infinity = std::numeric_limits<float>::infinity();
+
+  // Holding the scheduler keeps it alive for the whole search
+  const std::shared_ptr<TaskScheduler> scheduler = this->taskScheduler();
+  context->scheduler = scheduler.get();
+  context->splitDepth = splitDepth;
+  context->pruneThreshold = pruneThreshold;
+  context->wholeTurns = wholeTurns;
+
+  std::unique_ptr<SearchBudget> moveBudget;
+  SearchBudget* const budget = context->budget;
+
+  if (!budget && (timeBudgetMs > 0 || nodeBudget > 0)) {
+    moveBudget.reset(new SearchBudget(timeBudgetMs, nodeBudget));
+  }
+
+  SearchBudget* const limits = budget ? budget : moveBudget.get();
 
-  int source, dest;
-  this->bestMove(b, nextTile, depth, &source, &dest);
+  // Each iteration starts from the table the last one left, so it searches
+  // the best moves found so far first. The first always runs to completion
+  // so there is a move to play.
+  int source = -1, dest = -1;
+  context->completedDepth = 0;
+
+  for (int d = limits ? std::min(1, depth) : depth; d <= depth; d++) {
+    int s, t;
+
+    context->budget = d > 1 ? limits : nullptr;
+    this->bestMove(*context, board, nextTile, d, -infinity, infinity, 1.0, &s, &t);
+
+    if (context->stopped()) break;
+
+    source = s;
+    dest = t;
+    context->completedDepth = d;
+  }
+
+  context->budget = budget;
+  context->scheduler = nullptr;
 
   if (source < 0 || dest < 0) {
-    cout << "Failed!\n";
+    if (verbose) cout << "Failed!\n";
     return nullptr;
   }
 
-  t = clock() - t;      // End recording
+  const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;  // End recording
 
   auto newBoard = b->move(source, dest, nextTile);
 
+  *dist = GEOMETRY.dist[source][dest];
+  context->bestMove = Move(source, dest, *dist);
+
   if (verbose) {
-    // cout << "Next tile: " << nextTile.value << '\n';
-    cout << "Score: " << newBoard->score << ", Cash: " << newBoard->cash << '\n';
+    if (pruneThreshold > 0) {
+      cout << "Pruned " << context->prunedChildren << " chance children, error bound " << context->errorBound << '\n';
+    }
+
+    if (limits) cout << "Searched to a depth of " << context->completedDepth << '\n';
+
+    this->report(*newBoard, source, dest, elapsed.count());
+  }
+
+  return newBoard;
+}
+
+std::vector<TileResponse> EMM::solveAllTiles(const BoardPtr& b, int depth, SearchContext* context) {
+  tt.newSearch();
 
-    Board::printMove(source, dest);
+  alignas(64) Board board = *b;
 
-    cout << std::string(50, '-') << '\n';
+  const float infinity = std::numeric_limits<float>::infinity();
 
-    cout << "Took " << ((float)t)/CLOCKS_PER_SEC << " secs" << "\n\n";
+  const std::shared_ptr<TaskScheduler> scheduler = this->taskScheduler();
+  context->scheduler = scheduler.get();
+  context->splitDepth = splitDepth;
+  context->pruneThreshold = pruneThreshold;
+  context->wholeTurns = wholeTurns;
+
+  std::vector<TileResponse> responses(TILE_TYPES);
+
+  for (int i=0; i<TILE_TYPES; i++) {
+    int source, dest;
+
+    responses[i].tile = TILES[i];
+    responses[i].value = this->bestMove(*context, board, TILES[i], depth, -infinity, infinity, 1.0, &source, &dest);
+
+    if (source >= 0 && dest >= 0) {
+      responses[i].move = Move(source, dest, GEOMETRY.dist[source][dest]);
+    }
   }
 
-  const int diff = abs(source - dest);
-  *dist = diff/5 + diff%5;
+  context->scheduler = nullptr;
+
+  return responses;
+}
+
+std::vector<TileResponse> EMM::solveAllTiles(const BoardPtr& b, int depth) {
+  SearchContext context;
+  return this->solveAllTiles(b, depth, &context);
+}
+
+void EMM::report(const Board& newBoard, int source, int dest, float seconds) {
+  using std::cout;
+
+  // cout << "Next tile: " << nextTile.value << '\n';
+  cout << "Score: " << newBoard.score << ", Cash: " << newBoard.cash << '\n';
+
+  Board::printMove(source, dest);
+
+  cout << std::string(50, '-') << '\n';
+
+  cout << "Took " << seconds << " secs" << "\n\n";
+}
+
+// A move for commandParser: the pondered one when there is one, otherwise a
+// search that starts from what pondering left in the table
+BoardPtr EMM::play(const BoardPtr& b, const Tile& nextTile, int depth, int* dist) {
+  Move move;
+
+  if (ponderer && ponderer->lookup(*b, nextTile, depth, &move)) {
+    auto newBoard = b->move(move.source(), move.dest(), nextTile);
+
+    *dist = move.dist();
+    std::cout << "Pondered\n";
+    this->report(*newBoard, move.source(), move.dest(), 0.0);
+
+    return newBoard;
+  }
+
+  return this->solveBestMove(b, nextTile, depth, dist);
+}
+
+// Plays a tile and, after each jump, the same tile again
+BoardPtr EMM::playTurn(const BoardPtr& b, const Tile& nextTile, int depth) {
+  BoardPtr newBoard = b;
+  int dist = 0;
+  bool jumped = false;
+
+  do {
+    Move move;
+
+    if (jumped && this->continuationFromTable(*newBoard, nextTile, depth, &move)) {
+      newBoard = newBoard->move(move.source(), move.dest(), nextTile);
+
+      dist = move.dist();
+      std::cout << "From the table\n";
+      this->report(*newBoard, move.source(), move.dest(), 0.0);
+    } else {
+      newBoard = this->play(newBoard, nextTile, depth, &dist);
+    }
+
+    jumped = true;
+  } while (newBoard && dist > 1);
 
   return newBoard;
 }
 
+// The search for the jump reached the board after it as a chance node, and
+// the same tile on it as that node's child two plies below the root, or
+// deeper if the table kept a deeper search of it. Upper bounds are left
+// out, their move only failed low the least.
+bool EMM::continuationFromTable(const Board& b, const Tile& nextTile, int depth, Move* move) {
+  if (!jumpsFromTable || depth <= 2) return false;
+
+  SearchContext context;
+  context.wholeTurns = wholeTurns;
+
+  TTEntry entry;
+
+  if (!tt.probeAnyDepth(searchKey(context, b) ^ nextTileKey(nextTile), &entry)) return false;
+  if (entry.depth < depth - 2 || entry.bound == upperBound || entry.bestMove == Move()) return false;
+
+  const MoveList moves = b.getMoveset();
+  if (std::find(moves.begin(), moves.end(), entry.bestMove) == moves.end()) return false;
+
+  *move = entry.bestMove;
+  return true;
+}
+
+BoardPtr EMM::solveBestMove(
+        const BoardPtr& b,
+        const Tile& nextTile,
+        int depth,
+        int* dist,
+        bool verbose) {
+  SearchContext context;
+  return this->solveBestMove(b, nextTile, depth, dist, verbose, &context);
+}
+
 BoardPtr EMM::solveBestMove(
         const BoardPtr& b,
         const Tile& nextTile,
@@ -80,19 +269,13 @@ BoardPtr EMM::handleLawsuit(
         const BoardPtr& b,
         const int depth) {
   char c;
-  int dist = 0;
-  BoardPtr newBoard = b;
 
   currentLine >> c;
   const Tile tile = Tile(0, (c == '-') ? negativeLawsuit : positiveLawsuit);
 
   tileFile << c << ' ' << b->score << '\n';
 
-  do {
-    newBoard = this->solveBestMove(newBoard, tile, depth, &dist);
-  } while (dist > 1);
-
-  return newBoard;
+  return this->playTurn(b, tile, depth);
 }
 
 BoardPtr EMM::handleBonus(
@@ -104,6 +287,11 @@ BoardPtr EMM::handleBonus(
 
   currentLine >> cash >> pos;
 
+  if (cash < 0 || cash > Bonuses::MAX_VALUE || pos < 0 || pos >= BOARD_SIZE) {
+    std::cout << "Bonus out of range\n";
+    return b;
+  }
+
   tileFile << '$' << cash << ' ' << b->score << '\n';
 
   b->addBonus(pos, cash);
@@ -116,18 +304,18 @@ BoardPtr EMM::handleNonProfit(
         std::ofstream& tileFile,
         const BoardPtr& b,
         const int depth) {
-  int nonProfitValue, dist;
-  BoardPtr newBoard = b;
+  int nonProfitValue;
 
   currentLine >> nonProfitValue;
 
-  tileFile << '.' << nonProfitValue << ' ' << b->score << '\n';
+  if (!PackedTile::holds(nonProfitValue)) {
+    std::cout << "Tile value out of range\n";
+    return b;
+  }
 
-  do {
-    newBoard = this->solveBestMove(newBoard, Tile(nonProfitValue, nonProfit), depth, &dist);
-  } while (dist > 1);
+  tileFile << '.' << nonProfitValue << ' ' << b->score << '\n';
 
-  return newBoard;
+  return this->playTurn(b, Tile(nonProfitValue, nonProfit), depth);
 }
 
 void EMM::handleDebug(
@@ -142,13 +330,26 @@ void EMM::handleDebug(
   }
 }
 
+// Prints a line per tile: the tile, the move as source and dest positions
+// (-1 -1 when there is none) and its value
+void EMM::handleAllTiles(const BoardPtr& b, const int depth) {
+  for (const TileResponse& r : this->solveAllTiles(b, depth)) {
+    const bool hasMove = r.move != Move();
+
+    std::cout << r.tile << ' ' << (hasMove ? r.move.source() : -1) << ' ' << (hasMove ? r.move.dest() : -1);
+    std::cout << ' ' << r.value << '\n';
+  }
+}
+
 BoardPtr EMM::handleTile(
         const int nextTile,
         std::ofstream& tileFile,
         const BoardPtr& b,
         const int depth) {
-  int dist;
-  BoardPtr newBoard = b;
+  if (!PackedTile::holds(nextTile) || !PackedTile::holds(-nextTile)) {
+    std::cout << "Tile value out of range\n";
+    return b;
+  }
 
   // Record the tiles and score to file
   tileFile << nextTile << " " << b->score << '\n';
@@ -160,11 +361,7 @@ BoardPtr EMM::handleTile(
     t = Tile(-nextTile, competitor);
   }
 
-  do {
-    newBoard = this->solveBestMove(newBoard, t, depth, &dist);
-  } while (dist > 1);
-
-  return newBoard;
+  return this->playTurn(b, t, depth);
 }
 
 void EMM::commandParser(int depth) {
@@ -173,7 +370,20 @@ void EMM::commandParser(int depth) {
 
   BoardPtr b = std::make_shared<Board>();
 
-  while (getline(std::cin, line)){
+  // Ponders the board while waiting for each line, and stops before the line
+  // is handled, so only one search runs at a time
+  std::unique_ptr<Ponderer> pondering;
+
+  if (ponder) {
+    pondering.reset(new Ponderer(*this));
+    ponderer = pondering.get();
+  }
+
+  while (true) {
+    if (ponderer) ponderer->start(b, depth);
+    if (!getline(std::cin, line)) break;
+    if (ponderer) ponderer->stop();
+
     std::istringstream iss (line);
 
     char c;
@@ -200,6 +410,10 @@ void EMM::commandParser(int depth) {
         this->handleDebug(iss, myfile, b);
         break;
       }
+      case 'a': {
+        this->handleAllTiles(b, depth);
+        break;
+      }
       default: {
         const int nextTile = stoi(line);
         b = this->handleTile(nextTile, myfile, b, depth);
@@ -208,144 +422,625 @@ void EMM::commandParser(int depth) {
     }
   }
 
+  ponderer = nullptr;
   myfile.close();
 }
 
-int EMM::heuristicScore(const BoardPtr& b) {
-  int heuristicScore = 0;
+// Transposition keys cover the exact score and cash too, since the heuristic
+// and the bankruptcy check depend on them. Nodes of searches over whole turns
+// have other values, so they get other keys.
+uint64_t EMM::searchKey(const SearchContext& context, const Board& b) {
+  return b.stateKey() ^ (context.wholeTurns ? ZOBRIST.wholeTurns : 0);
+}
+
+int EMM::heuristicScore(const Board& b) {
+  return b.cash + b.score + BOARD_SIZE - b.numCompetitors();
+}
+
+void EMM::valueBounds(const Board& b, int depth, bool wholeTurns, float* lower, float* upper) {
+  // Range of the summed probabilities of a score band
+  static const auto bandSums = [] {
+    std::pair<float, float> sums(2.0, 0.0);
 
-  /*
-  // Look for it in cache
-  int key = hashBoard(*b);
-  map<int, int>::iterator it = hc.find(key);
+    for (int row=0; row<PROBABILITY_INTERVALS; row++) {
+      sums.first = std::min(sums.first, TILE_OUTCOMES[row].total);
+      sums.second = std::max(sums.second, TILE_OUTCOMES[row].total);
+    }
+
+    return sums;
+  }();
 
-  if (it != hc.end()) {
-    if (markReuse) {
-      reusedValues++;
+  // Largest competitor and regular tile the search can place
+  static const auto newTiles = [] {
+    std::pair<int, int> maxValues(0, 0);
+
+    for (int i=0; i<TILE_TYPES; i++) {
+      if (TILES[i].tileType == competitor) maxValues.first = std::max(maxValues.first, TILES[i].value);
+      if (TILES[i].tileType == regular) maxValues.second = std::max(maxValues.second, TILES[i].value);
     }
-    return it->second + b->cash + b->score;
+
+    return maxValues;
+  }();
+
+  // A max node at this depth makes a move every other ply down to the leaves.
+  // Over whole turns each jump of a turn is another move; a jump merges two
+  // tiles, and a turn adds at most one, so there are fewer jumps than tiles
+  // on the board and turns together.
+  const int turns = (depth + 1) / 2;
+  const int numCompetitors = b.numCompetitors();
+  const int tiles = BOARD_SIZE - __builtin_popcount(b.board.emptyMask());
+  const int moves = wholeTurns ? turns + tiles + turns : turns;
+
+  int maxTile = newTiles.second;
+  for (uint32_t m = b.board.typeMask(regular); m; m &= m - 1) {
+    maxTile = std::max(maxTile, b.board[__builtin_ctz(m)].value());
   }
 
-  // Add to hashtable
-  hc[key] = heuristicScore;
-  */
+  // The k-th move scores at most a merge or jump of a tile that has grown by
+  // one every move, plus the largest combo, or the largest bonus. Cash gains
+  // no more than the score, and pays at most the competitors' costs, which
+  // grow by a new competitor and an upgrade of every competitor per move.
+  const int maxCombo = 1 << (BOARD_WIDTH - 2);
+  int maxGain = 0;
+  int maxCosts = b.competitorCosts();
+
+  for (int k=1; k<=moves; k++) {
+    maxGain += std::max(maxTile + k + maxCombo, b.bonus.maxValue());
+    maxCosts += newTiles.first + std::min(BOARD_SIZE, numCompetitors + k);
+  }
+
+  // Boards that stay solvent keep non-negative cash; a bankrupt leaf lost at
+  // most one move's costs
+  const int minCash = moves ? std::min(0, -1 - maxCosts) : b.cash;
+  const float maxScore = b.cash + b.score + 2 * maxGain + BOARD_SIZE - std::max(0, numCompetitors - 3 * moves);
+  const float minScore = b.score + minCash + BOARD_SIZE - std::min(BOARD_SIZE, numCompetitors + moves);
+
+  // Each chance node on the way scales its children by its band's sum
+  float minScale = 1.0, maxScale = 1.0;
+  for (int k=0; k<turns; k++) {
+    minScale *= bandSums.first;
+    maxScale *= bandSums.second;
+  }
 
-  return heuristicScore + b->cash + b->score + BOARD_SIZE - b->numCompetitors();
+  *lower = std::min(minScore * minScale, minScore * maxScale);
+  *upper = std::max(maxScore * minScale, maxScore * maxScale);
 }
 
 float EMM::bestMove(
-        const BoardPtr& b,
+        SearchContext& context,
+        Board& b,
         const Tile& nextTile,
         int depth,
+        float alpha,
+        float beta,
+        float reach,
         int* source,
         int* dest) {
 
   *source = -1;
   *dest = -1;
 
-  if (depth == 0 || b->isBankrupt()) {
-    if (countLeafNodes) leafNodesExplored++;
+  if (depth == 0 || b.isBankrupt()) {
+    if (context.countLeafNodes) context.leafNodesExplored++;
     return this->heuristicScore(b);
   }
 
-  int chosenSource = -1;
-  int chosenDest = -1;
-  float bestScore = 0.0;
-  const bool isNonProfit = nextTile.tileType == nonProfit;
-  const bool isCompetitor = nextTile.tileType == competitor;
+  // Past the budget nothing is kept, so the value does not matter
+  if (context.budget && context.budget->spend()) return 0.0;
 
-  const auto allPossibleMoves = b->getMoveset();
+  const uint64_t key = searchKey(context, b) ^ nextTileKey(nextTile);
+  Move ttMove;
+
+  TTEntry entry;
+
+  if (tt.size()) context.ttProbes++;
+  if (tt.probe(key, depth, &entry)) {
+    if (entry.resolves(alpha, beta)) {
+      context.ttHits++;
+
+      if (entry.bestMove != Move()) {
+        *source = entry.bestMove.source();
+        *dest = entry.bestMove.dest();
+      }
+
+      return entry.value;
+    }
+
+    ttMove = entry.bestMove;
+  } else {
+    // A search to another depth, such as the one for the previous move,
+    // still knows which move to try first
+    tt.probeMove(key, &ttMove);
+  }
+
+  // Over whole turns the node branches once per board a turn can end in, up
+  // to as many as a move list holds, and the list holds each turn's first
+  // move, for the order and the table
+  std::vector<Turn> turns;
+  MoveList allPossibleMoves;
+
+  if (context.wholeTurns) {
+    turns = b.getTurns(nextTile, MoveList::CAPACITY);
+
+    for (const Turn& turn : turns) allPossibleMoves.push_back(turn.moves[0]);
+  } else {
+    allPossibleMoves = b.getMoveset();
+  }
 
   if (allPossibleMoves.empty()) {
-    if (countLeafNodes) leafNodesExplored++;
-    return this->heuristicScore(b);
+    if (context.countLeafNodes) context.leafNodesExplored++;
+
+    const float score = this->heuristicScore(b);
+    tt.store(key, depth, score, Move());
+
+    return score;
+  }
+
+  // The node is worth its best move if that scores above 0 and the heuristic
+  // otherwise. Either way it is at least beta when both are.
+  const float staticScore = this->heuristicScore(b);
+
+  if (beta <= 0 && staticScore >= beta) {
+    tt.store(key, depth, beta, Move(), lowerBound);
+    return beta;
   }
 
-  for (const auto &move : allPossibleMoves) {
-    int s, d, dist;
-    std::tie(s, d, dist) = move;
+  const bool isNonProfit = nextTile.tileType == nonProfit;
+  const bool isCompetitor = nextTile.tileType == competitor;
 
-    // Do not recommend moves where the competitor or nonProfit ends up in the
-    // corner
-    const bool badTile = isNonProfit || isCompetitor;
-    const bool isCorner = s == 0 || s == 4 || s == 20 || s == 24;
+  // Search the move that was best last time first; ties still go to the move
+  // that comes first in the move list
+  int order[MoveList::CAPACITY];
+  int numMoves = 0;
 
-    if (badTile && isCorner) continue;
+  for (int pass=0; pass<2; pass++) {
+    for (int i=0; i<allPossibleMoves.size(); i++) {
+      // The tile ends up where the last move of a turn started
+      const int s = (context.wholeTurns ? turns[i].last() : allPossibleMoves[i]).source();
 
-    auto nextBoard = b->move(s, d, nextTile);
-    const float score = this->expectiminimax(nextBoard, depth-1);
+      // Do not recommend moves where the competitor or nonProfit ends up in
+      // the corner
+      const bool badTile = isNonProfit || isCompetitor;
+      const bool isCorner = s == 0 || s == 4 || s == 20 || s == 24;
 
-    if (score > bestScore) {
-      chosenSource = s;
-      chosenDest = d;
+      if (badTile && isCorner) continue;
+      if ((allPossibleMoves[i] == ttMove) == (pass == 0)) order[numMoves++] = i;
+    }
+  }
+
+  // Scores of pruned subtrees depend on how the node was reached, and those
+  // of a stopped search are meaningless, so neither is stored. The node's
+  // error is the largest of its moves' errors.
+  const unsigned long prunedBefore = context.prunedChildren;
+  const double errorBefore = context.errorBound;
+  double moveError = 0.0;
+
+  int chosen = -1;
+  float bestScore = 0.0;
+  const float high = beta > 0 ? beta : std::numeric_limits<float>::min();
+
+  // Until a move scores above 0, a move only has to be told apart from 0
+  // when the heuristic would be inside the window
+  auto windowFor = [&](int index) {
+    if (chosen < 0) {
+      return staticScore > alpha ? 0.0f : std::max(alpha, 0.0f);
+    } else if (index < chosen && bestScore >= alpha) {
+      return std::nextafter(bestScore, -std::numeric_limits<float>::infinity());
+    } else {
+      return std::max(alpha, bestScore);
+    }
+  };
+
+  // Returns whether the move cuts the node off
+  auto update = [&](int index, float score) {
+    if (score > bestScore || (chosen >= 0 && score == bestScore && index < chosen)) {
+      chosen = index;
       bestScore = score;
     }
+
+    return chosen >= 0 && bestScore >= high;
+  };
+
+  // Moves often lead to the same board, like two equal tiles either of which
+  // can step aside for the same tile. A move whose board a move before it in
+  // the order led to takes that move's score. Turns all end in different
+  // boards already, and close to the leaves looking for a twin costs more
+  // than searching it again.
+  const bool findTwins = !context.wholeTurns && depth > 2;
+  uint64_t successors[MoveList::CAPACITY];
+  float scores[MoveList::CAPACITY];
+
+  auto findTwin = [&](int i, uint64_t successor) {
+    successors[i] = successor;
+
+    for (int j=0; j<i; j++) {
+      if (successors[j] == successor) {
+        context.duplicateSuccessors++;
+        return j;
+      }
+    }
+
+    return -1;
+  };
+
+  // When splitting, only the first move is searched here. The rest run as
+  // tasks with its score as their window and are merged in the same order.
+  const int serialMoves = context.splits(depth) ? std::min(1, numMoves) : numMoves;
+  bool cutoff = false;
+
+  for (int i=0; i<serialMoves && !cutoff; i++) {
+    const int index = order[i];
+    const float low = windowFor(index);
+
+    context.errorBound = 0.0;
+
+    if (context.wholeTurns) {
+      Board end = turns[index].board;
+      scores[i] = this->expectiminimax(context, end, depth-1, low, high, reach);
+    } else {
+      MoveUndo undo;
+      b.makeMove(allPossibleMoves[index].source(), allPossibleMoves[index].dest(), nextTile, &undo);
+
+      const int twin = findTwins ? findTwin(i, b.stateKey()) : -1;
+      scores[i] = twin >= 0 ? scores[twin] : this->expectiminimax(context, b, depth-1, low, high, reach);
+      b.unmakeMove(undo);
+    }
+
+    moveError = std::max(moveError, context.errorBound);
+
+    cutoff = update(index, scores[i]);
   }
 
-  *source = chosenSource;
-  *dest = chosenDest;
+  if (!cutoff && serialMoves < numMoves) {
+    int twins[MoveList::CAPACITY];
+    std::vector<SearchContext> contexts(numMoves, context.fork());
+    TaskScheduler::Group group;
 
-  if (chosenSource < 0) {
-    if (countLeafNodes) leafNodesExplored++;
-    return this->heuristicScore(b);
-  } else {
-    return bestScore;
+    for (int i=serialMoves; i<numMoves; i++) {
+      const Move move = allPossibleMoves[order[i]];
+      twins[i] = -1;
+
+      if (findTwins) {
+        MoveUndo undo;
+        b.makeMove(move.source(), move.dest(), nextTile, &undo);
+        twins[i] = findTwin(i, b.stateKey());
+        b.unmakeMove(undo);
+
+        if (twins[i] >= 0) continue;
+      }
+
+      const Turn* turn = context.wholeTurns ? &turns[order[i]] : nullptr;
+      const float low = windowFor(order[i]);
+      SearchContext* taskContext = &contexts[i];
+      float* score = &scores[i];
+
+      context.scheduler->spawn(group, [this, b, move, turn, nextTile, depth, low, high, reach, taskContext, score]() mutable {
+        if (turn) {
+          b = turn->board;
+        } else {
+          MoveUndo undo;
+          b.makeMove(move.source(), move.dest(), nextTile, &undo);
+        }
+
+        *score = this->expectiminimax(*taskContext, b, depth-1, low, high, reach);
+      });
+    }
+
+    context.scheduler->wait(group);
+
+    for (int i=serialMoves; i<numMoves; i++) {
+      if (twins[i] >= 0) scores[i] = scores[twins[i]];
+    }
+
+    for (int i=serialMoves; i<numMoves; i++) {
+      moveError = std::max(moveError, contexts[i].errorBound);
+      contexts[i].errorBound = 0.0;
+      context.merge(contexts[i]);
+    }
+
+    for (int i=serialMoves; i<numMoves && !update(order[i], scores[i]); i++);
   }
+
+  context.errorBound = errorBefore + moveError;
+
+  if (chosen < 0) {
+    if (context.countLeafNodes) context.leafNodesExplored++;
+
+    if (context.prunedChildren == prunedBefore && !context.stopped()) {
+      tt.store(key, depth, staticScore, Move(), staticScore >= beta ? lowerBound : exactValue);
+    }
+
+    return staticScore;
+  }
+
+  const Move move = allPossibleMoves[chosen];
+  const ValueBound bound = bestScore >= beta ? lowerBound : bestScore <= alpha ? upperBound : exactValue;
+
+  *source = move.source();
+  *dest = move.dest();
+  if (context.prunedChildren == prunedBefore && !context.stopped()) tt.store(key, depth, bestScore, move, bound);
+
+  return bestScore;
 }
 
-float EMM::expectiminimax(const BoardPtr& board, int depth) {
-  if (depth == 0 || board->isBankrupt()) {
-    if (countLeafNodes) leafNodesExplored++;
+float EMM::expectiminimax(SearchContext& context, Board& board, int depth, float alpha, float beta, float reach) {
+  if (depth == 0 || board.isBankrupt()) {
+    if (context.countLeafNodes) context.leafNodesExplored++;
     return this->heuristicScore(board);
   }
 
-  const int distribRow = std::min(board->score/100, PROBABILITY_INTERVALS-1);
+  if (context.budget && context.budget->spend()) return 0.0;
+
+  const uint64_t key = searchKey(context, board);
+
+  TTEntry entry;
+
+  if (tt.size()) context.ttProbes++;
+  if (tt.probe(key, depth, &entry) && entry.resolves(alpha, beta)) {
+    context.ttHits++;
+    return entry.value;
+  }
+
+  const TileOutcomes& outcomes = TILE_OUTCOMES[std::min(board.score/100, PROBABILITY_INTERVALS-1)];
+
+  // Star1: with every child's value within [lower, upper], stop as soon as
+  // the children left cannot bring the expected value back inside the
+  // window. The margin covers rounding in the window arithmetic.
+  float lower, upper;
+  valueBounds(board, depth-1, context.wholeTurns, &lower, &upper);
+  const float margin = 1e-4f * (1.0f + std::fabs(lower) + std::fabs(upper));
+
+  float remaining = outcomes.total;
 
   float expectedMaxScore = 0.0;
-  for (int i=0; i<TILE_TYPES; i++) {
+
+  // Below the threshold a child gets the heuristic, kept within the bounds
+  // of its value. Outcomes are most likely first, so checking the last one
+  // tells whether any is pruned. Nodes with a pruned subtree stay out of the
+  // table, since their values depend on the probability they were reached
+  // with, and so do nodes of a stopped search.
+  const unsigned long prunedBefore = context.prunedChildren;
+  float prunedScore = 0.0, prunedError = 0.0;
+
+  auto isPruned = [&](float probability) {
+    return context.pruneThreshold > 0 && depth > 1 && reach * probability < context.pruneThreshold;
+  };
+
+  if (isPruned(outcomes.outcomes[outcomes.count - 1].probability)) {
+    prunedScore = std::min(std::max(static_cast<float>(this->heuristicScore(board)), lower), upper);
+    prunedError = std::max(upper - prunedScore, prunedScore - lower);
+  }
+
+  auto prune = [&](float probability) {
+    context.prunedChildren++;
+    context.errorBound += static_cast<double>(reach) * probability * prunedError;
+    return prunedScore;
+  };
+
+  auto store = [&](float value, ValueBound bound) {
+    if (context.prunedChildren == prunedBefore && !context.stopped()) tt.store(key, depth, value, Move(), bound);
+  };
+
+  // When splitting, the children run as tasks, so each window assumes its
+  // siblings are at their bounds rather than at their values
+  if (context.splits(depth)) {
+    float alphas[TILE_TYPES], betas[TILE_TYPES], scores[TILE_TYPES];
+
+    for (int i=0; i<outcomes.count; i++) {
+      const float probability = outcomes.outcomes[i].probability;
+      const float others = std::max(remaining - probability, 0.0f);
+      alphas[i] = (alpha - margin - others * upper) / probability;
+      betas[i] = (beta + margin - others * lower) / probability;
+
+      if (upper <= alphas[i]) {
+        store(alpha, upperBound);
+        return alpha;
+      }
+      if (lower >= betas[i]) {
+        store(beta, lowerBound);
+        return beta;
+      }
+    }
+
+    std::vector<SearchContext> contexts(outcomes.count, context.fork());
+    TaskScheduler::Group group;
+
+    for (int i=0; i<outcomes.count; i++) {
+      if (isPruned(outcomes.outcomes[i].probability)) {
+        scores[i] = prune(outcomes.outcomes[i].probability);
+        continue;
+      }
+
+      const Tile tile = outcomes.outcomes[i].tile;
+      const float childReach = reach * outcomes.outcomes[i].probability;
+      const float childAlpha = alphas[i];
+      const float childBeta = betas[i];
+      SearchContext* taskContext = &contexts[i];
+      float* score = &scores[i];
+
+      context.scheduler->spawn(group, [this, board, tile, depth, childAlpha, childBeta, childReach, taskContext, score]() mutable {
+        int source, dest;
+        *score = this->bestMove(*taskContext, board, tile, depth-1, childAlpha, childBeta, childReach, &source, &dest);
+      });
+    }
+
+    context.scheduler->wait(group);
+    for (int i=0; i<outcomes.count; i++) context.merge(contexts[i]);
+
+    for (int i=0; i<outcomes.count; i++) {
+      const float probability = outcomes.outcomes[i].probability;
+
+      if (scores[i] <= alphas[i]) {
+        store(alpha, upperBound);
+        return alpha;
+      }
+      if (scores[i] >= betas[i]) {
+        store(beta, lowerBound);
+        return beta;
+      }
+
+      expectedMaxScore += scores[i] * probability;
+    }
+
+    store(expectedMaxScore,
+        expectedMaxScore >= beta ? lowerBound : expectedMaxScore <= alpha ? upperBound : exactValue);
+
+    return expectedMaxScore;
+  }
+
+  for (const auto& outcome : outcomes) {
     int source, dest;
 
-    const Tile tile = TILES[i];
-    const float probability = DISTRIBUTION[distribRow][i];
+    const Tile tile = outcome.tile;
+    const float probability = outcome.probability;
 
-    const float heuristicScore = this->bestMove(board, tile, depth-1, &source, &dest);
+    remaining -= probability;
+    const float remainingLow = std::max(remaining, 0.0f) * lower;
+    const float remainingHigh = std::max(remaining, 0.0f) * upper;
+
+    const float childAlpha = (alpha - margin - expectedMaxScore - remainingHigh) / probability;
+    const float childBeta = (beta + margin - expectedMaxScore - remainingLow) / probability;
+
+    if (upper <= childAlpha) {
+      store(alpha, upperBound);
+      return alpha;
+    }
+    if (lower >= childBeta) {
+      store(beta, lowerBound);
+      return beta;
+    }
+
+    const float heuristicScore = isPruned(probability)
+        ? prune(probability)
+        : this->bestMove(context, board, tile, depth-1, childAlpha, childBeta, reach * probability, &source, &dest);
+
+    if (heuristicScore <= childAlpha) {
+      store(alpha, upperBound);
+      return alpha;
+    }
+    if (heuristicScore >= childBeta) {
+      store(beta, lowerBound);
+      return beta;
+    }
 
     expectedMaxScore += heuristicScore * probability;
   }
 
+  store(expectedMaxScore,
+      expectedMaxScore >= beta ? lowerBound : expectedMaxScore <= alpha ? upperBound : exactValue);
+
   return expectedMaxScore;
 }
 
-int EMM::rolloutOnce(int depth) {
+// The scheduler for this EMM's thread count, created on first use and
+// replaced when the count changes; null when searching on one thread
+std::shared_ptr<TaskScheduler> EMM::taskScheduler() {
+  std::lock_guard<std::mutex> lock(schedulerMutex);
+
+  if (threads <= 1) {
+    scheduler.reset();
+  } else if (!scheduler || scheduler->size() != threads) {
+    scheduler = std::make_shared<TaskScheduler>(threads);
+  }
+
+  return scheduler;
+}
+
+GameResult EMM::playGame(int depth, uint64_t seed, uint64_t game, int maxMoves) {
+  GameResult result;
   BoardPtr b = std::make_shared<Board>();
+  SearchContext context;
+  CounterRng rng(seed, game);
+
+  auto limitReached = [&] {
+    return maxMoves && result.moves >= maxMoves;
+  };
 
   while (true) {
-    int dist = 10;
-    const Tile newTile = Board::getRandomTile(b->score);
+    if (b->isBankrupt()) {
+      result.ending = bankruptcy;
+      break;
+    }
+    if (limitReached()) {
+      result.ending = moveLimitReached;
+      break;
+    }
+
+    const Tile newTile = Board::getRandomTile(b->score, rng);
+    BoardPtr next;
+    int dist;
+    bool jumped = false;
 
+    // A jump moves again with the same tile
     do {
-      b = this->solveBestMove(b, newTile, depth, &dist, false);
-      // std::cout << '.';
+      Move move;
+
+      if (jumped && this->continuationFromTable(*b, newTile, depth, &move)) {
+        next = b->move(move.source(), move.dest(), newTile);
+        dist = move.dist();
+      } else {
+        next = this->solveBestMove(b, newTile, depth, &dist, false, &context);
+      }
 
-      if (!b) return 0;
-      std::cout << "Score: " << b->score << ", Cash: " << b->cash << '\n';
-      // std::cout << *b;
+      jumped = true;
 
-    } while (dist > 1);
+      if (!next) break;
+      b = next;
+      result.moves++;
+    } while (dist > 1 && !b->isBankrupt() && !limitReached());
+
+    if (!next) {
+      result.ending = b->getMoveset().empty() ? noMovesLeft : searchFailed;
+      break;
+    }
   }
 
-  int score = b->score;
-  std::cout << "\nScore: " << b->score << ", Cash: " << b->cash << '\n';
+  result.score = b->score;
+  result.cash = b->cash;
 
-  return score;
+  return result;
 }
 
-void EMM::rollout(int depth) {
-  const int numRollouts = 6;
+RolloutReport EMM::rollout(int numGames, int jobs, int depth, uint64_t seed, int maxMoves) {
+  RolloutReport report;
+  report.games.resize(numGames);
 
-  srand(time(0));
+  const auto start = std::chrono::steady_clock::now();
+
+  std::atomic<int> nextGame(0);
+  auto play = [&] {
+    for (int i; (i = nextGame++) < numGames; ) {
+      report.games[i] = this->playGame(depth, seed, i, maxMoves);
+    }
+  };
 
-  for (int i=0; i<numRollouts; i++) {
-    this->rolloutOnce(depth);
+  std::vector<std::thread> players;
+  for (int i=1; i<jobs; i++) players.emplace_back(play);
+  play();
+  for (auto& player : players) player.join();
+
+  report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<double> scores, lengths;
+  for (const GameResult& game : report.games) {
+    scores.push_back(game.score);
+    lengths.push_back(game.moves);
+    report.endings[game.ending]++;
   }
+
+  report.scores = summarize(scores);
+  report.lengths = summarize(lengths);
+
+  return report;
+}
+
+std::ostream& operator<<(std::ostream& os, const RolloutReport& r) {
+  os << "Games: " << r.games.size() << ", took " << r.seconds << " secs\n";
+  os << "Score: " << r.scores << '\n';
+  os << "Moves: " << r.lengths << '\n';
+  os << "Endings: " << r.endings[bankruptcy] << " bankrupt, " << r.endings[noMovesLeft] << " out of moves, ";
+  os << r.endings[searchFailed] << " without a move from the search, ";
+  os << r.endings[moveLimitReached] << " at the move limit\n";
+
+  return os;
 }
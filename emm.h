@@ -1,30 +1,174 @@
 #ifndef __EMM_H__
 #define __EMM_H__
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "board.h"
+#include "budget.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "tt.h"
+
+// Everything a single search changes as it runs, along with the settings it
+// runs with. The search functions take it as a parameter instead of keeping
+// it in EMM, so one EMM can run several searches at once. A task the search
+// hands to another thread gets a fork, merged back once the task is done.
+struct SearchContext {
+  bool countLeafNodes = false;
+  unsigned long leafNodesExplored = 0;
+  unsigned long ttProbes = 0;
+  unsigned long ttHits = 0;
+
+  // Moves of max nodes that lead to the same board as a move searched before
+  // them, which take that move's score instead of a search
+  unsigned long duplicateSuccessors = 0;
+
+  // Nodes at least splitDepth plies from the leaves run their children as
+  // tasks on the scheduler, if there is one
+  TaskScheduler* scheduler = nullptr;
+  int splitDepth = 0;
+
+  // Chance children reached with a probability below pruneThreshold are
+  // scored by the heuristic instead of searched. errorBound adds up how far
+  // each of them can be from its searched value, weighted by that
+  // probability, which bounds the error of the root value.
+  float pruneThreshold = 0.0;
+  unsigned long prunedChildren = 0;
+  double errorBound = 0.0;
+
+  // With a budget, solveBestMove deepens one ply at a time until the budget
+  // runs out and plays bestMove, found by the deepest search that finished.
+  SearchBudget* budget = nullptr;
+  int completedDepth = 0;
+  Move bestMove;
+
+  // Whether max nodes branch over whole turns rather than single moves
+  bool wholeTurns = false;
+
+  SearchContext fork() const;
+  void merge(const SearchContext& context);
+  bool splits(int depth) const;
+  bool stopped() const;
+};
+
+// The best move for a tile and its value; move is Move() when the tile has
+// no move
+struct TileResponse {
+  Tile tile;
+  Move move;
+  float value = 0.0;
+};
+
+// How a game of a rollout ended. searchFailed covers a board with moves the
+// search did not recommend any of, such as a competitor's moves that all
+// end in a corner.
+enum GameEnding { bankruptcy, noMovesLeft, searchFailed, moveLimitReached, GAME_ENDINGS };
+
+struct GameResult {
+  int score = 0;
+  int cash = 0;
+  int moves = 0;
+  GameEnding ending = bankruptcy;
+};
+
+// The games of a rollout and statistics over them
+struct RolloutReport {
+  std::vector<GameResult> games;
+  Summary scores;
+  Summary lengths;
+  int endings[GAME_ENDINGS] = {0};
+  double seconds = 0.0;
+};
+
+std::ostream& operator<<(std::ostream& os, const RolloutReport& r);
+
+class Ponderer;
 
 class EMM {
   public:
-    bool markReuse = false;
-    bool countLeafNodes = false;
-    int reusedValues = 0;
-    unsigned long leafNodesExplored = 0;
+    // Transposition table shared by the chance and max nodes of a search and
+    // kept from one search to the next, so a move starts from what the
+    // search for the previous one learned; empty (disabled) until sized.
+    TranspositionTable tt;
+
+    // Threads a search runs on, sharing tt; nodes at least splitDepth plies
+    // from the leaves hand their children to the other threads as tasks.
+    int threads = 1;
+    int splitDepth = 4;
+
+    // Probability below which a chance child is not searched; 0 searches
+    // every child.
+    float pruneThreshold = 0.0;
+
+    // Per-move limits; with either set, solveBestMove deepens iteratively up
+    // to its depth and plays the deepest search that finished in time.
+    int timeBudgetMs = 0;
+    unsigned long nodeBudget = 0;
+
+    // Whether commandParser searches the likeliest next tiles while it waits
+    // for input
+    bool ponder = false;
+
+    // Whether a max node branches over whole turns, a jump being followed by
+    // another move with the same tile as in the game, instead of over single
+    // moves with a new tile after every one. The move after a jump is then
+    // searched at the same depth, mostly from the table.
+    bool wholeTurns = false;
 
-    void rollout(int depth);
-    int rolloutOnce(int depth);
+    // Whether the move after a jump is the one the search for the jump left
+    // in the table, two plies shallower, instead of a new search, so a turn
+    // costs about one search. It needs the table, and playing the shallower
+    // move is weaker; clear it to search every move of a turn.
+    bool jumpsFromTable = true;
+
+    // Plays numGames games on jobs threads without printing anything. Game i
+    // draws its tiles from stream i of seed, so playGame(depth, seed, i, ...)
+    // replays it exactly; maxMoves of 0 lets games run until they cannot go
+    // on.
+    RolloutReport rollout(int numGames, int jobs, int depth, uint64_t seed, int maxMoves);
+    GameResult playGame(int depth, uint64_t seed, uint64_t game, int maxMoves);
     void commandParser(int depth);
     BoardPtr solveBestMove(const BoardPtr& b, const Tile& nextTile, int depth, int *dist);
     BoardPtr solveBestMove(const BoardPtr& b, const Tile& nextTile, int depth, int *dist, bool verbose);
+    BoardPtr solveBestMove(const BoardPtr& b, const Tile& nextTile, int depth, int *dist, bool verbose, SearchContext* context);
+
+    // The best move and its value for every entry of TILES, in the same
+    // order. The searches share one table, so each starts from the subtrees
+    // the ones before it cached.
+    std::vector<TileResponse> solveAllTiles(const BoardPtr& b, int depth, SearchContext* context);
+    std::vector<TileResponse> solveAllTiles(const BoardPtr& b, int depth);
+
+    // With jumpsFromTable, the move for nextTile on the board a jump left,
+    // if the depth-ply search for the jump found one
+    bool continuationFromTable(const Board& b, const Tile& nextTile, int depth, Move* move);
     BoardPtr handleLawsuit(std::istringstream& currentLine, std::ofstream& tileFile, const BoardPtr& b, const int depth);
     BoardPtr handleBonus(std::istringstream& currentLine, std::ofstream& tileFile, const BoardPtr& b, const int depth);
     BoardPtr handleNonProfit(std::istringstream& currentLine, std::ofstream& tileFile, const BoardPtr& b, const int depth);
     void handleDebug(std::istringstream& currentLine, std::ofstream& tileFile, const BoardPtr& b);
+    void handleAllTiles(const BoardPtr& b, const int depth);
     BoardPtr handleTile(const int nextTile, std::ofstream& tileFile, const BoardPtr& b, const int depth);
 
   private:
-    int heuristicScore(const BoardPtr& b);
-    float bestMove(const BoardPtr& b, const Tile& nextTile, int depth, int* source, int* dest);
-    float expectiminimax(const BoardPtr& board, int depth);
+    std::shared_ptr<TaskScheduler> scheduler;
+    std::mutex schedulerMutex;
+
+    // Set while commandParser ponders
+    Ponderer* ponderer = nullptr;
+
+    BoardPtr play(const BoardPtr& b, const Tile& nextTile, int depth, int* dist);
+    BoardPtr playTurn(const BoardPtr& b, const Tile& nextTile, int depth);
+    static void report(const Board& newBoard, int source, int dest, float seconds);
+
+    std::shared_ptr<TaskScheduler> taskScheduler();
+
+    static uint64_t searchKey(const SearchContext& context, const Board& b);
+    int heuristicScore(const Board& b);
+    static void valueBounds(const Board& b, int depth, bool wholeTurns, float* lower, float* upper);
+    float bestMove(SearchContext& context, Board& b, const Tile& nextTile, int depth, float alpha, float beta, float reach, int* source, int* dest);
+    float expectiminimax(SearchContext& context, Board& board, int depth, float alpha, float beta, float reach);
 };
 
 #endif
@@ -0,0 +1,86 @@
+#ifndef __MOVE_H__
+#define __MOVE_H__
+
+#include <cstdint>
+
+#include "constants.h"
+
+// A move packed into 16 bits: source and dest positions in five bits each and
+// the distance travelled in the next three. A distance above 1 is a jump.
+class Move {
+  public:
+    Move()
+        : bits(0) {}
+
+    Move(int source, int dest, int dist)
+        : bits(static_cast<uint16_t>(source | dest << DEST_SHIFT | dist << DIST_SHIFT)) {}
+
+    int source() const {
+      return bits & POS_MASK;
+    }
+
+    int dest() const {
+      return bits >> DEST_SHIFT & POS_MASK;
+    }
+
+    int dist() const {
+      return bits >> DIST_SHIFT & DIST_MASK;
+    }
+
+    bool isJump() const {
+      return this->dist() > 1;
+    }
+
+    bool operator==(const Move& m) const {
+      return bits == m.bits;
+    }
+
+    bool operator!=(const Move& m) const {
+      return bits != m.bits;
+    }
+
+  private:
+    static const int DEST_SHIFT = 5;
+    static const int DIST_SHIFT = 10;
+    static const int POS_MASK = (1 << DEST_SHIFT) - 1;
+    static const int DIST_MASK = 7;
+
+    uint16_t bits;
+};
+
+// Fixed-capacity list of moves that lives on the stack, so generating moves
+// never allocates. Every source has at most 8 destinations.
+class MoveList {
+  public:
+    static const int CAPACITY = BOARD_SIZE * 8;
+
+    void push_back(const Move& m) {
+      moves[count++] = m;
+    }
+
+    int size() const {
+      return count;
+    }
+
+    bool empty() const {
+      return count == 0;
+    }
+
+    const Move& operator[](int i) const {
+      return moves[i];
+    }
+
+    const Move* begin() const {
+      return moves;
+    }
+
+    const Move* end() const {
+      return moves + count;
+    }
+
+  private:
+    Move moves[CAPACITY];
+    int count = 0;
+};
+
+#endif
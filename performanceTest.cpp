@@ -1,9 +1,8 @@
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <memory>
 
-#include <time.h>
-
 #include "board.h"
 #include "tile.h"
 #include "emm.h"
@@ -21,18 +20,42 @@ std::string formatWithCommas(const T& t) {
   return numWithCommas;
 }
 
+// Usage: performanceTest [depth] [--tt-mb megabytes] [--threads n] [--split-depth plies]
+//                        [--prune-threshold probability]
 int main(int argc, const char* argv[]) {
   int depth = 6;
+  size_t ttMegabytes = 16;
+  int threads = 1;
+  int splitDepth = 4;
+  float pruneThreshold = 0.0;
 
   int dist;
   BoardPtr b = std::make_shared<Board>();
   std::shared_ptr<EMM> emm = std::make_shared<EMM>();
-  emm->countLeafNodes = true;
+  SearchContext context;
+  context.countLeafNodes = true;
+
+  for (int i=1; i<argc; i++) {
+    std::string arg (argv[i]);
 
-  if (argc == 2) {
-    depth = std::stoi(argv[1]);
+    if (arg == "--tt-mb" && i+1 < argc) {
+      ttMegabytes = std::stoul(argv[++i]);
+    } else if (arg == "--threads" && i+1 < argc) {
+      threads = std::stoi(argv[++i]);
+    } else if (arg == "--split-depth" && i+1 < argc) {
+      splitDepth = std::stoi(argv[++i]);
+    } else if (arg == "--prune-threshold" && i+1 < argc) {
+      pruneThreshold = std::stof(argv[++i]);
+    } else {
+      depth = std::stoi(arg);
+    }
   }
 
+  emm->tt.resize(ttMegabytes);
+  emm->threads = threads;
+  emm->splitDepth = splitDepth;
+  emm->pruneThreshold = pruneThreshold;
+
   b->board = {Tile(7), Tile(4),             Tile(2),                  Tile(4),             Tile(7),
               Tile(6), Tile(3, competitor), Tile(1),                  Tile(3, nonProfit),  Tile(6),
               Tile(3), Tile(2),             Tile(0, positiveLawsuit), Tile(2),             Tile(3),
@@ -41,16 +64,31 @@ int main(int argc, const char* argv[]) {
   b->addCompetitor(6, Tile(3, competitor));
   b->addCompetitor(18, Tile(3, competitor));
 
-  clock_t t = clock();  // Start recording
+  const auto start = std::chrono::steady_clock::now();  // Start recording
 
-  emm->solveBestMove(b, Tile(5, competitor), depth, &dist, false);
+  emm->solveBestMove(b, Tile(5, competitor), depth, &dist, false, &context);
 
-  t = clock() - t;      // End recording
+  const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;  // End recording
 
   // Print numbers nicely with commas
   std::cout << "Explored to a depth of " << depth;
-  std::cout << ", nodes = " << formatWithCommas(emm->leafNodesExplored) << '\n';
-  std::cout << "Took " << ((float)t)/CLOCKS_PER_SEC << " secs" << "\n\n";
+  std::cout << ", nodes = " << formatWithCommas(context.leafNodesExplored) << '\n';
+
+  if (context.ttProbes) {
+    std::cout << "Transposition table hits = " << formatWithCommas(context.ttHits);
+    std::cout << " / " << formatWithCommas(context.ttProbes);
+    std::cout << " (" << 100.0 * context.ttHits / context.ttProbes << "%)\n";
+  }
+
+  std::cout << "Duplicate successors = " << formatWithCommas(context.duplicateSuccessors) << '\n';
+
+  if (pruneThreshold > 0) {
+    std::cout << "Pruned " << formatWithCommas(context.prunedChildren) << " chance children";
+    std::cout << ", error bound = " << context.errorBound << '\n';
+  }
+
+  std::cout << "Explored with " << threads << (threads == 1 ? " thread" : " threads") << '\n';
+  std::cout << "Took " << elapsed.count() << " secs" << "\n\n";
 
   return 0;
 }
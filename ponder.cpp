@@ -0,0 +1,67 @@
+#include <algorithm>
+
+#include "emm.h"
+#include "ponder.h"
+
+Ponderer::Ponderer(EMM& emm)
+    : emm(emm) {}
+
+Ponderer::~Ponderer() {
+  this->stop();
+}
+
+void Ponderer::start(const BoardPtr& b, int depth) {
+  this->stop();
+
+  board = *b;
+  this->depth = depth;
+  results.clear();
+
+  // Unlimited, so it only runs out when stopped
+  budget.reset(new SearchBudget(0, 0));
+  thread = std::thread(&Ponderer::run, this);
+}
+
+void Ponderer::stop() {
+  if (budget) budget->stop();
+  this->wait();
+}
+
+void Ponderer::wait() {
+  if (thread.joinable()) thread.join();
+}
+
+bool Ponderer::lookup(const Board& b, const Tile& tile, int depth, Move* move) {
+  std::lock_guard<std::mutex> lock(resultsMutex);
+
+  if (depth != this->depth || !(b == board)) return false;
+
+  for (const Result& result : results) {
+    if (result.tile == tile) {
+      *move = result.move;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Ponderer::run() {
+  const BoardPtr b = std::make_shared<Board>(board);
+  const TileOutcomes& outcomes = TILE_OUTCOMES[std::min(board.score/100, PROBABILITY_INTERVALS-1)];
+
+  for (const auto& outcome : outcomes) {
+    SearchContext context;
+    context.budget = budget.get();
+
+    int dist;
+    const BoardPtr next = emm.solveBestMove(b, outcome.tile, depth, &dist, false, &context);
+
+    if (budget->exhausted()) break;
+
+    if (next && context.completedDepth == depth) {
+      std::lock_guard<std::mutex> lock(resultsMutex);
+      results.push_back({outcome.tile, context.bestMove});
+    }
+  }
+}
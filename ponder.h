@@ -0,0 +1,56 @@
+#ifndef __PONDER_H__
+#define __PONDER_H__
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "budget.h"
+#include "move.h"
+#include "tile.h"
+
+class EMM;
+
+// Searches a board for its likeliest next tiles on a background thread,
+// most likely first, while the EMM waits for the tile that does come. The
+// searches share the EMM's table, so a tile that was not reached still
+// starts warm.
+class Ponderer {
+  public:
+    explicit Ponderer(EMM& emm);
+    ~Ponderer();
+
+    // Starts pondering b to the given depth, stopping any earlier pondering
+    void start(const BoardPtr& b, int depth);
+
+    // Stops pondering and waits for the search in progress to unwind
+    void stop();
+
+    // Waits for every tile to be pondered
+    void wait();
+
+    // The move for tile on b, if pondering searched it to the given depth
+    bool lookup(const Board& b, const Tile& tile, int depth, Move* move);
+
+  private:
+    struct Result {
+      Tile tile;
+      Move move;
+    };
+
+    EMM& emm;
+    std::thread thread;
+    std::unique_ptr<SearchBudget> budget;
+
+    Board board;
+    int depth = 0;
+
+    std::mutex resultsMutex;
+    std::vector<Result> results;
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <cstdint>
+
+constexpr uint64_t splitmix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+  return z ^ (z >> 31);
+}
+
+// Counter-based generator: draw n of a stream is SplitMix64 at position n of
+// a sequence keyed by (seed, stream), so it is a pure function of the three
+// and streams can be replayed or handed to threads independently
+class CounterRng {
+  public:
+    CounterRng(uint64_t seed, uint64_t stream)
+        : key(streamKey(seed, stream)) {}
+
+    uint64_t at(uint64_t n) const {
+      uint64_t state = key + n * 0x9e3779b97f4a7c15ULL;
+      return splitmix64(&state);
+    }
+
+    uint64_t next() {
+      return this->at(counter++);
+    }
+
+    uint64_t position() const {
+      return counter;
+    }
+
+  private:
+    uint64_t key;
+    uint64_t counter = 0;
+
+    static uint64_t streamKey(uint64_t seed, uint64_t stream) {
+      uint64_t state = seed;
+      const uint64_t seedKey = splitmix64(&state);
+
+      state = stream ^ 0x6a09e667f3bcc909ULL;
+      return seedKey ^ splitmix64(&state);
+    }
+};
+
+#endif
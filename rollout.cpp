@@ -1,12 +1,73 @@
+#include <iostream>
 #include <memory>
+#include <string>
 
 #include "emm.h"
 
-int main() {
+// Usage: rollout [--games n] [--jobs n] [--depth plies] [--seed s]
+//                [--max-moves n] [--tt-mb megabytes] [--threads n]
+//                [--whole-turns] [--jumps-from-table]
+//
+// Plays --games games, --jobs of them at a time, and prints statistics of
+// their final scores, lengths and endings. --threads is the number of
+// threads each search runs on. --whole-turns searches jump chains as part of
+// the move that starts them. --jumps-from-table plays the move after a jump
+// from the table the search for the jump left instead of searching again;
+// the table is off unless --tt-mb is given, so the flag needs it.
+int main(int argc, const char* argv[]) {
+  int numGames = 6;
+  int jobs = 1;
+  int depth = 6;
+  uint64_t seed = 1;
+  int maxMoves = 0;
+  size_t ttMegabytes = 0;
+  int threads = 1;
+  bool wholeTurns = false;
+  bool jumpsFromTable = false;
+
+  for (int i=1; i<argc; i++) {
+    std::string arg (argv[i]);
+
+    if (arg == "--whole-turns") {
+      wholeTurns = true;
+      continue;
+    }
+    if (arg == "--jumps-from-table") {
+      jumpsFromTable = true;
+      continue;
+    }
+
+    if (i+1 >= argc) break;
+
+    if (arg == "--games") {
+      numGames = std::stoi(argv[++i]);
+    } else if (arg == "--jobs") {
+      jobs = std::stoi(argv[++i]);
+    } else if (arg == "--depth") {
+      depth = std::stoi(argv[++i]);
+    } else if (arg == "--seed") {
+      seed = std::stoull(argv[++i]);
+    } else if (arg == "--max-moves") {
+      maxMoves = std::stoi(argv[++i]);
+    } else if (arg == "--tt-mb") {
+      ttMegabytes = std::stoul(argv[++i]);
+    } else if (arg == "--threads") {
+      threads = std::stoi(argv[++i]);
+    }
+  }
+
+  if (jumpsFromTable && ttMegabytes == 0) {
+    std::cerr << "--jumps-from-table needs a table, set its size with --tt-mb\n";
+    return 1;
+  }
 
   std::shared_ptr<EMM> emm = std::make_shared<EMM>();
+  emm->tt.resize(ttMegabytes);
+  emm->threads = threads;
+  emm->wholeTurns = wholeTurns;
+  emm->jumpsFromTable = jumpsFromTable;
 
-  emm->rollout(6);
+  std::cout << emm->rollout(numGames, jobs, depth, seed, maxMoves);
 
   return 0;
 
@@ -0,0 +1,92 @@
+#include <chrono>
+
+#include "scheduler.h"
+
+static thread_local int threadIndex = 0;
+
+TaskScheduler::TaskScheduler(int numThreads)
+    : stopping(false), queued(0) {
+  for (int i=0; i<numThreads; i++) queues.emplace_back(new Queue());
+
+  for (int i=1; i<numThreads; i++) {
+    workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  stopping = true;
+  wakeUp.notify_all();
+
+  for (auto& worker : workers) worker.join();
+}
+
+int TaskScheduler::size() const {
+  return queues.size();
+}
+
+int TaskScheduler::currentThread() {
+  return threadIndex;
+}
+
+void TaskScheduler::spawn(Group& group, Task task) {
+  Queue& queue = *queues[threadIndex];
+
+  group.pending++;
+
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.emplace_back(&group, std::move(task));
+  }
+
+  queued++;
+  wakeUp.notify_one();
+}
+
+void TaskScheduler::wait(Group& group) {
+  while (group.pending > 0) {
+    if (!this->runOne(threadIndex)) std::this_thread::yield();
+  }
+}
+
+bool TaskScheduler::runOne(int self) {
+  const int numThreads = queues.size();
+  std::pair<Group*, Task> task;
+
+  // Newest task of our own first, then the oldest task of another thread
+  for (int i=0; i<numThreads && !task.first; i++) {
+    Queue& queue = *queues[(self + i) % numThreads];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) continue;
+
+    if (i == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+  }
+
+  if (!task.first) return false;
+
+  queued--;
+  task.second();
+  task.first->pending--;
+
+  return true;
+}
+
+void TaskScheduler::workerLoop(int self) {
+  threadIndex = self;
+
+  while (!stopping) {
+    if (this->runOne(self)) continue;
+
+    // The timeout covers a task spawned between the check and the wait
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeUp.wait_for(lock, std::chrono::milliseconds(1), [this] {
+      return stopping || queued > 0;
+    });
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fork/join scheduler with one task deque per thread. A thread pushes and
+// pops its own tasks at the back and steals from the front of the others',
+// so it works depth-first on its own subtree while thieves take the largest
+// pending subtrees. Thread 0 is whichever thread spawns the first tasks;
+// it runs tasks while it waits on a group, the others run them whenever
+// there are any.
+class TaskScheduler {
+  public:
+    typedef std::function<void()> Task;
+
+    // The outstanding tasks of one fork/join
+    class Group {
+      public:
+        Group() : pending(0) {}
+
+      private:
+        friend class TaskScheduler;
+        std::atomic<int> pending;
+    };
+
+    explicit TaskScheduler(int numThreads);
+    ~TaskScheduler();
+
+    int size() const;
+
+    // Index of the calling thread in its scheduler, 0 outside of a worker
+    static int currentThread();
+
+    void spawn(Group& group, Task task);
+
+    // Runs tasks until every task spawned into the group has finished
+    void wait(Group& group);
+
+  private:
+    struct Queue {
+      std::mutex mutex;
+      std::deque<std::pair<Group*, Task>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+    std::atomic<int> queued;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    bool runOne(int self);
+    void workerLoop(int self);
+};
+
+#endif
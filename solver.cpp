@@ -1,12 +1,65 @@
 #include <memory>
+#include <string>
 
 #include "emm.h"
 
-int main() {
+// Usage: solver [--tt-mb megabytes] [--threads n] [--prune-threshold probability]
+//               [--time-ms milliseconds] [--max-depth plies] [--ponder]
+//               [--whole-turns] [--search-jumps]
+//
+// With a prune threshold, chance children less likely than it are scored by
+// the heuristic, and each move reports a bound on the error this causes.
+//
+// With a time budget, each move deepens until the budget runs out, up to
+// --max-depth (20 unless given); without one it searches to --max-depth (6).
+// --ponder searches the likeliest next tiles while waiting for input.
+// --whole-turns searches jump chains as part of the move that starts them.
+// The move after a jump is the one the search for the jump left in the
+// table; --search-jumps searches it again instead.
+int main(int argc, const char* argv[]) {
+  size_t ttMegabytes = 16;
+  int threads = 1;
+  float pruneThreshold = 0.0;
+  int timeMs = 0;
+  int maxDepth = 0;
+  bool ponder = false;
+  bool wholeTurns = false;
+  bool searchJumps = false;
+
+  for (int i=1; i<argc; i++) {
+    std::string arg (argv[i]);
+
+    if (arg == "--tt-mb" && i+1 < argc) {
+      ttMegabytes = std::stoul(argv[++i]);
+    } else if (arg == "--threads" && i+1 < argc) {
+      threads = std::stoi(argv[++i]);
+    } else if (arg == "--prune-threshold" && i+1 < argc) {
+      pruneThreshold = std::stof(argv[++i]);
+    } else if (arg == "--time-ms" && i+1 < argc) {
+      timeMs = std::stoi(argv[++i]);
+    } else if (arg == "--max-depth" && i+1 < argc) {
+      maxDepth = std::stoi(argv[++i]);
+    } else if (arg == "--ponder") {
+      ponder = true;
+    } else if (arg == "--whole-turns") {
+      wholeTurns = true;
+    } else if (arg == "--search-jumps") {
+      searchJumps = true;
+    }
+  }
+
+  if (maxDepth <= 0) maxDepth = timeMs > 0 ? 20 : 6;
 
   std::shared_ptr<EMM> emm = std::make_shared<EMM>();
+  emm->tt.resize(ttMegabytes);
+  emm->threads = threads;
+  emm->pruneThreshold = pruneThreshold;
+  emm->timeBudgetMs = timeMs;
+  emm->ponder = ponder;
+  emm->wholeTurns = wholeTurns;
+  emm->jumpsFromTable = !searchJumps;
 
-  emm->commandParser(6);
+  emm->commandParser(maxDepth);
 
   return 0;
 
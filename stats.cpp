@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cmath>
+
+#include "stats.h"
+
+Summary summarize(std::vector<double> sample) {
+  Summary s;
+  s.count = sample.size();
+
+  if (sample.empty()) return s;
+
+  std::sort(sample.begin(), sample.end());
+
+  double sum = 0.0;
+  for (double x : sample) sum += x;
+  s.mean = sum / s.count;
+
+  if (s.count > 1) {
+    double squares = 0.0;
+    for (double x : sample) squares += (x - s.mean) * (x - s.mean);
+
+    s.stddev = std::sqrt(squares / (s.count - 1));
+    s.confidence95 = 1.96 * s.stddev / std::sqrt(s.count);
+  }
+
+  s.min = sample.front();
+  s.p10 = percentile(sample, 0.10);
+  s.p25 = percentile(sample, 0.25);
+  s.median = percentile(sample, 0.50);
+  s.p75 = percentile(sample, 0.75);
+  s.p90 = percentile(sample, 0.90);
+  s.max = sample.back();
+
+  return s;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+
+  const double rank = p * (sorted.size() - 1);
+  const size_t below = std::floor(rank);
+  const size_t above = std::min(below + 1, sorted.size() - 1);
+
+  return sorted[below] + (rank - below) * (sorted[above] - sorted[below]);
+}
+
+std::ostream& operator<<(std::ostream& os, const Summary& s) {
+  os << "mean " << s.mean << " +/- " << s.confidence95 << " (95% CI), sd " << s.stddev << '\n';
+  os << "  min " << s.min << ", p10 " << s.p10 << ", p25 " << s.p25 << ", median " << s.median;
+  os << ", p75 " << s.p75 << ", p90 " << s.p90 << ", max " << s.max;
+
+  return os;
+}
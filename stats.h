@@ -0,0 +1,34 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <ostream>
+#include <vector>
+
+// Summary statistics of a sample
+struct Summary {
+  int count = 0;
+  double mean = 0.0;
+  double stddev = 0.0;
+
+  // Half-width of the normal-approximation 95% confidence interval of the
+  // mean
+  double confidence95 = 0.0;
+
+  double min = 0.0;
+  double p10 = 0.0;
+  double p25 = 0.0;
+  double median = 0.0;
+  double p75 = 0.0;
+  double p90 = 0.0;
+  double max = 0.0;
+};
+
+Summary summarize(std::vector<double> sample);
+
+// The p-th percentile (p in [0, 1]) of a sorted sample, interpolating
+// linearly between the closest ranks
+double percentile(const std::vector<double>& sorted, double p);
+
+std::ostream& operator<<(std::ostream& os, const Summary& s);
+
+#endif
@@ -1,7 +1,9 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iterator>
 #include <tuple>
+#include <vector>
 
 #include "catch.hpp"
 
@@ -24,7 +26,7 @@ TEST_CASE("Board initialization", "[Board]") {
   }
 
   for (int i=0; i<BOARD_SIZE; i++) {
-    REQUIRE(b->competitorTimers[i] == 0);
+    REQUIRE(b->timer(i) == 0);
     REQUIRE(b->bonus[i] == 0);
   }
 
@@ -101,10 +103,11 @@ void REQUIRE_MOVESET_EQUAL(
 
   auto moveset = b->getMoveset();
 
-  REQUIRE(moveset.size() == expectedMoveset.size());
+  REQUIRE(moveset.size() == static_cast<int>(expectedMoveset.size()));
 
   for (auto &move: expectedMoveset) {
-    auto locate = std::find(moveset.begin(), moveset.end(), move);
+    const Move expected (std::get<0>(move), std::get<1>(move), std::get<2>(move));
+    auto locate = std::find(moveset.begin(), moveset.end(), expected);
 
     REQUIRE(locate != moveset.end());
   }
@@ -160,6 +163,7 @@ TEST_CASE("addCompetitor", "[Board]") {
   b->addCompetitor(5, Tile(2, competitor));
   REQUIRE(b->isCompetitor(5));
   REQUIRE(b->competitorCosts() == 3);
+  REQUIRE(b->numCompetitors() == 2);
 }
 
 TEST_CASE("clearCompetitor", "[Board]") {
@@ -173,7 +177,9 @@ TEST_CASE("clearCompetitor", "[Board]") {
 
   b->clearCompetitor(0);
   REQUIRE(!b->isCompetitor(0));
+  REQUIRE(b->isEmpty(0));
   REQUIRE(b->isCompetitor(5));
+  REQUIRE(b->numCompetitors() == 1);
 
 
   b->clearCompetitor(5);
@@ -203,6 +209,24 @@ TEST_CASE("bonus is decreased after each move", "[Board]") {
   REQUIRE(b3->bonus[1] == 9);
 }
 
+TEST_CASE("every cell keeps its own bonus", "[Board]") {
+  BoardPtr b (new Board());
+
+  for (int pos=0; pos<BOARD_SIZE; pos++) b->addBonus(pos, 20 + pos);
+
+  // A bonus of 0 on a cell without one leaves the others alone
+  b->addBonus(9, 0);
+  b->addBonus(9, 0);
+
+  for (int pos=0; pos<BOARD_SIZE; pos++) REQUIRE(b->bonus[pos] == (pos == 9 ? 0 : 20 + pos));
+  REQUIRE(b->hash() == b->recomputeHash());
+
+  auto b2 = b->move(12, 13, Tile(1));
+  REQUIRE(b2->bonus[0] == 19);
+  REQUIRE(b2->bonus[24] == 43);
+  REQUIRE(b2->hash() == b2->recomputeHash());
+}
+
 TEST_CASE("bonus is added to cash", "[Board]") {
   BoardPtr b (new Board());
   const int bonusVal = 5;
@@ -295,6 +319,49 @@ TEST_CASE("jump", "[Board]") {
   REQUIRE(b3->score == b2->score + fusionBonus + comboBonus);
 }
 
+TEST_CASE("getTurns lists each end of a turn once", "[Board]") {
+  BoardPtr b (new Board());
+
+  // Jumping 12 onto 10 or 14 leaves a 2 that can jump with the one at 0
+  b->board[0] = Tile(2);
+  b->board[10] = Tile(1);
+  b->board[14] = Tile(1);
+
+  const Tile tile (1);
+  const std::vector<Turn> turns = b->getTurns(tile, 1000);
+  std::vector<uint64_t> ends;
+  int longest = 0;
+
+  for (const Turn& turn : turns) {
+    BoardPtr played = b;
+
+    // Jumps up to the last move, which is not one unless nothing follows it
+    for (int i=0; i<turn.count; i++) {
+      const Move& m = turn.moves[i];
+
+      if (i < turn.count - 1) REQUIRE(m.isJump());
+      played = played->move(m.source(), m.dest(), tile);
+    }
+
+    REQUIRE((!turn.last().isJump() || played->getMoveset().empty()));
+    REQUIRE(*played == turn.board);
+
+    ends.push_back(turn.board.stateKey());
+    longest = std::max(longest, turn.count);
+  }
+
+  std::sort(ends.begin(), ends.end());
+  REQUIRE(std::adjacent_find(ends.begin(), ends.end()) == ends.end());
+  REQUIRE(longest == 3);
+
+  // Every walk is a turn of its own
+  int walks = 0;
+  for (const Move& m : b->getMoveset()) walks += !m.isJump();
+  REQUIRE(static_cast<int>(turns.size()) > walks);
+
+  REQUIRE(b->getTurns(tile, 3).size() == 3);
+}
+
 TEST_CASE("walk", "[Board]") {
   BoardPtr b (new Board());
 
@@ -361,3 +428,266 @@ TEST_CASE("walk", "[Board]") {
   REQUIRE(b6->cash == b5->cash);     // Cash unchanged
   REQUIRE(b6->score == b5->score);   // Score unchanged
 }
+
+/*
+ * REQUIRE_MAKE_UNMAKE_CONSISTENT:
+ *    Test that every legal move applied in place matches Board::move and that
+ *    unmaking it restores the original board.
+ */
+void REQUIRE_MAKE_UNMAKE_CONSISTENT(BoardPtr b, const Tile& nextTile) {
+  const Board original = *b;
+
+  for (const auto &move: b->getMoveset()) {
+    const int s = move.source();
+    const int d = move.dest();
+
+    auto moved = b->move(s, d, nextTile);
+
+    Board inPlace = original;
+    MoveUndo undo;
+    inPlace.makeMove(s, d, nextTile, &undo);
+    REQUIRE(inPlace == *moved);
+
+    inPlace.unmakeMove(undo);
+    REQUIRE(inPlace == original);
+  }
+}
+
+TEST_CASE("makeMove and unmakeMove", "[Board]") {
+  BoardPtr b (new Board());
+
+  b->board = {Tile(7), Tile(4),             Tile(2),                  Tile(4),             Tile(7),
+              Tile(6), Tile(3, competitor), Tile(1),                  Tile(3, nonProfit),  Tile(6),
+              Tile(3), Tile(2),             Tile(0, positiveLawsuit), Tile(2),             Tile(3),
+              Tile(6), Tile(3, nonProfit),  Tile(1),                  Tile(3, competitor), Tile(6),
+              Tile(7), Tile(4),             Tile(2),                  Tile(4),             Tile(7)};
+  b->addCompetitor(6, Tile(3, competitor));
+  b->addCompetitor(18, Tile(3, competitor));
+  b->addBonus(12, 3);
+
+  for (const auto &tile: TILES) {
+    REQUIRE_MAKE_UNMAKE_CONSISTENT(b, tile);
+  }
+
+  // --------------------------------------------------------------------------
+  // Competitor timers run out and jumps destroy several tiles
+  BoardPtr b2 (new Board());
+
+  b2->board[10] = Tile(4);
+  b2->board[14] = Tile(4);
+  b2->board[11] = Tile(0, negativeLawsuit);
+  b2->addCompetitor(12, Tile(1, competitor));
+  b2->addCompetitor(13, Tile(0, competitor));
+  b2->board[0] = Tile(0, negativeLawsuit);
+  b2->addCompetitor(1, Tile(0, competitor));
+  b2->setTimer(13, 0);
+  b2->addBonus(11, 1);
+
+  for (const auto &tile: TILES) {
+    REQUIRE_MAKE_UNMAKE_CONSISTENT(b2, tile);
+  }
+}
+
+TEST_CASE("tickTimers matches tickTimersScalar", "[Board]") {
+  srand(0);
+
+  for (int round=0; round<1000; round++) {
+    uint8_t timers[Board::TIMER_LANES] = {0};
+    uint8_t expected[Board::TIMER_LANES] = {0};
+    uint32_t competitors = 0;
+
+    for (int i=0; i<BOARD_SIZE; i++) {
+      timers[i] = expected[i] = rand() % 4 ? rand() % 19 : 0;
+      if (rand() % 2) competitors |= 1u << i;
+    }
+
+    const uint32_t expectedExpired = Board::tickTimersScalar(expected, competitors);
+    REQUIRE(Board::tickTimers(timers, competitors) == expectedExpired);
+
+    for (int i=0; i<Board::TIMER_LANES; i++) {
+      REQUIRE(timers[i] == expected[i]);
+    }
+  }
+}
+
+TEST_CASE("competitor is upgraded when its timer runs out", "[Board]") {
+  BoardPtr b (new Board());
+
+  b->addCompetitor(0, Tile(1, competitor));
+  b->addBonus(24, 2);
+
+  // Walk 12 into 13 and clear 13 again, so the same move stays legal
+  for (int i=17; i>0; i--) {
+    b = b->move(12, 13, Tile(1));
+    b->board[13] = Tile();
+    REQUIRE(b->timer(0) == i - 1);
+    REQUIRE(b->board[0] == Tile(1, competitor));
+  }
+
+  REQUIRE(b->bonus[24] == 0);
+
+  b = b->move(12, 13, Tile(1));
+  REQUIRE(b->timer(0) == 18);
+  REQUIRE(b->board[0] == Tile(2, competitor));
+  REQUIRE(b->competitorCosts() == 2);
+}
+
+TEST_CASE("competitors keep upgrading past 23", "[Board]") {
+  BoardPtr b (new Board());
+
+  b->addCompetitor(0, Tile(30, competitor));
+  b->board[1] = Tile(40);
+  REQUIRE(b->board[1].value() == 40);
+
+  // Walk 12 into 13 and clear 13 again until the timer runs out
+  for (int i=17; i>0; i--) {
+    b = b->move(12, 13, Tile(1));
+    b->board[13] = Tile();
+  }
+
+  Board upgraded = *b;
+  MoveUndo undo;
+  upgraded.makeMove(12, 13, Tile(1), &undo);
+  REQUIRE(upgraded.board[0] == Tile(31, competitor));
+  REQUIRE(upgraded.competitorCosts() == 31);
+  REQUIRE(upgraded.hash() == upgraded.recomputeHash());
+
+  upgraded.unmakeMove(undo);
+  REQUIRE(upgraded == *b);
+  REQUIRE(upgraded.hash() == b->hash());
+}
+
+TEST_CASE("unmakeMove restores the timer of a saturated competitor", "[Board]") {
+  BoardPtr b (new Board());
+
+  b->addCompetitor(0, Tile(PackedTile::MAX_VALUE, competitor));
+
+  for (int i=17; i>0; i--) {
+    b = b->move(12, 13, Tile(1));
+    b->board[13] = Tile();
+  }
+
+  REQUIRE(b->timer(0) == 0);
+
+  Board inPlace = *b;
+  MoveUndo undo;
+  inPlace.makeMove(12, 13, Tile(1), &undo);
+  REQUIRE(inPlace.timer(0) == 18);
+  REQUIRE(inPlace.board[0] == Tile(PackedTile::MAX_VALUE, competitor));
+  REQUIRE(inPlace.hash() == inPlace.recomputeHash());
+
+  inPlace.unmakeMove(undo);
+  REQUIRE(inPlace.timer(0) == 0);
+  REQUIRE(inPlace == *b);
+  REQUIRE(inPlace.hash() == inPlace.recomputeHash());
+  REQUIRE(inPlace.hash() == b->hash());
+}
+
+TEST_CASE("hash is kept up to date", "[Board]") {
+  BoardPtr b (new Board());
+
+  REQUIRE(b->hash() == b->recomputeHash());
+
+  b->addBonus(7, 3);
+  b->addCompetitor(0, Tile(1, competitor));
+  b->board[10] = Tile(1);
+  REQUIRE(b->hash() == b->recomputeHash());
+
+  // Play a fixed sequence of moves, checking each step and its undo
+  srand(0);
+  for (int i=0; i<200 && !b->getMoveset().empty(); i++) {
+    const auto moves = b->getMoveset();
+    const auto move = moves[rand() % moves.size()];
+    const Tile tile = TILES[rand() % TILE_TYPES];
+
+    Board inPlace = *b;
+    MoveUndo undo;
+    inPlace.makeMove(move.source(), move.dest(), tile, &undo);
+    REQUIRE(inPlace.hash() == inPlace.recomputeHash());
+
+    inPlace.unmakeMove(undo);
+    REQUIRE(inPlace.hash() == b->hash());
+
+    b = b->move(move.source(), move.dest(), tile);
+    REQUIRE(b->hash() == b->recomputeHash());
+  }
+
+  // Two move orders reaching the same board give the same key
+  BoardPtr c (new Board());
+  c->board[10] = Tile(1);
+  c->board[14] = Tile(1);
+
+  auto viaLeft = c->move(12, 11, Tile(1))->move(14, 13, Tile(1));
+  auto viaRight = c->move(14, 13, Tile(1))->move(12, 11, Tile(1));
+  REQUIRE(*viaLeft == *viaRight);
+  REQUIRE(viaLeft->hash() == viaRight->hash());
+
+  // Score band is part of the key
+  BoardPtr d (new Board(*c));
+  d->score += 100;
+  REQUIRE(d->hash() != c->hash());
+}
+
+TEST_CASE("Tile samplers follow the normalized distribution", "[Board]") {
+  for (int row=0; row<PROBABILITY_INTERVALS; row++) {
+    double sum = 0.0, total = 0.0;
+    for (int i=0; i<TILE_TYPES; i++) sum += DISTRIBUTION[row][i];
+
+    for (int i=0; i<TILE_TYPES; i++) {
+      const double p = TILE_SAMPLERS[row].probability(i);
+
+      REQUIRE(std::abs(p - DISTRIBUTION[row][i] / sum) < 1e-9);
+      if (DISTRIBUTION[row][i] == 0) REQUIRE(p == 0.0);
+      total += p;
+    }
+
+    REQUIRE(std::abs(total - 1.0) < 1e-12);
+  }
+}
+
+TEST_CASE("getRandomTile never draws a tile of probability 0", "[Board]") {
+  CounterRng rng(1, 0);
+
+  for (int row=0; row<PROBABILITY_INTERVALS; row++) {
+    const int score = row * 100;
+    const uint64_t extremes[] = {0, ~0ULL, 0xffffffffULL, ~0ULL << 32};
+
+    for (int i=0; i<10000 + 4; i++) {
+      const uint64_t draw = i < 4 ? extremes[i] : rng.next();
+      const Tile t = Board::getRandomTile(score, draw);
+      const int index = std::find(TILES, TILES + TILE_TYPES, t) - TILES;
+
+      REQUIRE(index < TILE_TYPES);
+      REQUIRE(DISTRIBUTION[row][index] > 0);
+    }
+  }
+}
+
+TEST_CASE("Tile outcomes list the nonzero tiles of a band, most likely first", "[Board]") {
+  for (int row=0; row<PROBABILITY_INTERVALS; row++) {
+    const TileOutcomes& outcomes = TILE_OUTCOMES[row];
+    int nonzero = 0;
+
+    for (int i=0; i<TILE_TYPES; i++) {
+      if (DISTRIBUTION[row][i] == 0) continue;
+
+      nonzero++;
+      const auto outcome = std::find_if(outcomes.begin(), outcomes.end(), [i](const TileOutcomes::Outcome& o) {
+        return o.tile == TILES[i];
+      });
+
+      REQUIRE(outcome != outcomes.end());
+      REQUIRE(outcome->probability == DISTRIBUTION[row][i]);
+    }
+
+    REQUIRE(outcomes.count == nonzero);
+
+    float total = 0.0;
+    for (int i=0; i<outcomes.count; i++) {
+      if (i > 0) REQUIRE(outcomes.outcomes[i-1].probability >= outcomes.outcomes[i].probability);
+      total += outcomes.outcomes[i].probability;
+    }
+
+    REQUIRE(outcomes.total == total);
+  }
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "board.h"
+#include "emm.h"
+#include "ponder.h"
+
+static BoardPtr setUp() {
+  BoardPtr b = std::make_shared<Board>();
+
+  b->board = {Tile(7), Tile(4),             Tile(2),                  Tile(4),             Tile(7),
+              Tile(6), Tile(3, competitor), Tile(1),                  Tile(3, nonProfit),  Tile(6),
+              Tile(3), Tile(2),             Tile(0, positiveLawsuit), Tile(2),             Tile(3),
+              Tile(6), Tile(3, nonProfit),  Tile(1),                  Tile(3, competitor), Tile(6),
+              Tile(7), Tile(4),             Tile(2),                  Tile(4),             Tile(7)};
+  b->addCompetitor(6, Tile(3, competitor));
+  b->addCompetitor(18, Tile(3, competitor));
+
+  return b;
+}
+
+static const std::vector<Tile> NEXT_TILES = {
+  Tile(5, competitor), Tile(2), Tile(1), Tile(0, competitor), Tile(2),
+  Tile(1, competitor), Tile(1), Tile(2), Tile(2, competitor), Tile(1)
+};
+
+// The boards the EMM plays through NEXT_TILES
+static std::vector<Board> playGame(EMM& emm) {
+  std::vector<Board> boards;
+  BoardPtr b = setUp();
+
+  for (const Tile& tile : NEXT_TILES) {
+    int dist;
+    b = emm.solveBestMove(b, tile, 4, &dist, false);
+
+    if (!b) break;
+    boards.push_back(*b);
+  }
+
+  return boards;
+}
+
+static std::vector<Board> playGame(int threads, int splitDepth) {
+  EMM emm;
+  emm.tt.resize(1);
+  emm.threads = threads;
+  emm.splitDepth = splitDepth;
+
+  return playGame(emm);
+}
+
+TEST_CASE("Parallel search chooses the same moves as a single thread", "[EMM]") {
+  const std::vector<Board> expected = playGame(1, 0);
+  REQUIRE(expected.size() == NEXT_TILES.size());
+
+  for (int splitDepth : {1, 2, 4}) {
+    REQUIRE(playGame(4, splitDepth) == expected);
+  }
+}
+
+TEST_CASE("Concurrent parallel searches choose the same moves as a single thread", "[EMM]") {
+  const std::vector<Board> expected = playGame(1, 0);
+
+  const int numGames = 4;
+  std::vector<std::vector<Board>> games(numGames);
+  std::vector<std::thread> threads;
+
+  for (int i=0; i<numGames; i++) {
+    threads.emplace_back([&games, i] { games[i] = playGame(3, 1 + i % 3); });
+  }
+
+  for (auto& thread : threads) thread.join();
+  for (int i=0; i<numGames; i++) REQUIRE(games[i] == expected);
+}
+
+TEST_CASE("One EMM plays concurrent games", "[EMM]") {
+  const std::vector<Board> expected = playGame(1, 0);
+
+  for (int threads : {1, 2}) {
+    EMM emm;
+    emm.tt.resize(1);
+    emm.threads = threads;
+    emm.splitDepth = 2;
+
+    const int numGames = 4;
+    std::vector<std::vector<Board>> games(numGames);
+    std::vector<std::thread> players;
+
+    for (int i=0; i<numGames; i++) {
+      players.emplace_back([&emm, &games, i] { games[i] = playGame(emm); });
+    }
+
+    for (auto& player : players) player.join();
+    for (int i=0; i<numGames; i++) REQUIRE(games[i] == expected);
+  }
+}
+
+TEST_CASE("Rollouts play the same games on any number of threads", "[EMM]") {
+  EMM emm;
+
+  const RolloutReport serial = emm.rollout(6, 1, 2, 42, 0);
+  const RolloutReport parallel = emm.rollout(6, 3, 2, 42, 0);
+
+  REQUIRE(serial.games.size() == 6);
+  REQUIRE(serial.scores.count == 6);
+
+  for (int i=0; i<6; i++) {
+    REQUIRE(serial.games[i].score == parallel.games[i].score);
+    REQUIRE(serial.games[i].moves == parallel.games[i].moves);
+    REQUIRE(serial.games[i].ending == parallel.games[i].ending);
+    REQUIRE(serial.games[i].ending != moveLimitReached);
+    REQUIRE((serial.games[i].ending == bankruptcy) == (serial.games[i].cash < 0));
+  }
+
+  // Any game of a batch can be replayed on its own
+  const GameResult replay = emm.playGame(2, 42, 4, 0);
+  REQUIRE(replay.score == serial.games[4].score);
+  REQUIRE(replay.moves == serial.games[4].moves);
+
+  const GameResult limited = emm.playGame(2, 42, 0, 5);
+  REQUIRE(limited.moves == 5);
+  REQUIRE(limited.ending == moveLimitReached);
+}
+
+TEST_CASE("Chance pruning reports the children it skipped and their error", "[EMM]") {
+  EMM emm;
+  emm.tt.resize(1);
+
+  int dist;
+  SearchContext exact;
+  REQUIRE(emm.solveBestMove(setUp(), NEXT_TILES[0], 6, &dist, false, &exact));
+  REQUIRE(exact.prunedChildren == 0);
+  REQUIRE(exact.errorBound == 0.0);
+
+  // A threshold below every path probability prunes nothing
+  emm.pruneThreshold = 1e-12;
+  REQUIRE(playGame(emm) == playGame(1, 0));
+
+  emm.pruneThreshold = 0.01;
+  SearchContext pruned;
+  REQUIRE(emm.solveBestMove(setUp(), NEXT_TILES[0], 6, &dist, false, &pruned));
+  REQUIRE(pruned.prunedChildren > 0);
+  REQUIRE(pruned.errorBound > 0.0);
+  REQUIRE(std::isfinite(pruned.errorBound));
+}
+
+TEST_CASE("Iterative deepening plays the deepest search that finished", "[EMM]") {
+  const std::vector<Board> expected = playGame(1, 0);
+
+  // A budget that never runs out reaches the full depth
+  EMM unlimited;
+  unlimited.tt.resize(1);
+  unlimited.nodeBudget = 1000000000;
+  REQUIRE(playGame(unlimited) == expected);
+
+  EMM emm;
+  emm.tt.resize(1);
+  emm.nodeBudget = 100;
+
+  int dist;
+  SearchContext context;
+  REQUIRE(emm.solveBestMove(setUp(), NEXT_TILES[0], 6, &dist, false, &context));
+  REQUIRE(context.completedDepth >= 1);
+  REQUIRE(context.completedDepth < 6);
+  REQUIRE(context.bestMove.dist() == dist);
+}
+
+TEST_CASE("Pondering finds the moves a search would", "[EMM]") {
+  EMM emm;
+  emm.tt.resize(1);
+
+  const BoardPtr b = setUp();
+  const TileOutcomes& outcomes = TILE_OUTCOMES[std::min(b->score/100, PROBABILITY_INTERVALS-1)];
+
+  Ponderer ponderer(emm);
+  ponderer.start(b, 4);
+  ponderer.wait();
+
+  for (const auto& outcome : outcomes) {
+    Move move;
+    REQUIRE(ponderer.lookup(*b, outcome.tile, 4, &move));
+
+    EMM fresh;
+    fresh.tt.resize(1);
+
+    int dist;
+    const BoardPtr next = fresh.solveBestMove(b, outcome.tile, 4, &dist, false);
+    REQUIRE(*next == *b->move(move.source(), move.dest(), outcome.tile));
+    REQUIRE(move.dist() == dist);
+  }
+
+  // Other depths and boards are not pondered
+  Move move;
+  REQUIRE(!ponderer.lookup(*b, outcomes.outcomes[0].tile, 5, &move));
+  REQUIRE(!ponderer.lookup(Board(), outcomes.outcomes[0].tile, 4, &move));
+
+  // Stopping unwinds a search that would take far longer
+  ponderer.start(b, 12);
+  ponderer.stop();
+  REQUIRE(!ponderer.lookup(*b, outcomes.outcomes[0].tile, 12, &move));
+}
+
+TEST_CASE("solveAllTiles answers every tile like a search for it alone", "[EMM]") {
+  EMM emm;
+  emm.tt.resize(1);
+
+  const BoardPtr b = setUp();
+  const std::vector<TileResponse> responses = emm.solveAllTiles(b, 4);
+
+  REQUIRE(responses.size() == TILE_TYPES);
+
+  for (int i=0; i<TILE_TYPES; i++) {
+    REQUIRE(responses[i].tile == TILES[i]);
+
+    EMM fresh;
+    fresh.tt.resize(1);
+
+    int dist;
+    const BoardPtr next = fresh.solveBestMove(b, TILES[i], 4, &dist, false);
+    const Move move = responses[i].move;
+
+    REQUIRE(next);
+    REQUIRE(*next == *b->move(move.source(), move.dest(), TILES[i]));
+    REQUIRE(move.dist() == dist);
+  }
+}
+
+TEST_CASE("The move after a jump comes from the search for the jump", "[EMM]") {
+  BoardPtr b = std::make_shared<Board>();
+  b->board[0] = Tile(2);
+  b->board[10] = Tile(1);
+  b->board[14] = Tile(1);
+
+  EMM emm;
+  emm.tt.resize(1);
+  REQUIRE(emm.jumpsFromTable);
+
+  const Tile tile (1, competitor);
+  int dist;
+
+  const BoardPtr jumped = emm.solveBestMove(b, tile, 4, &dist, false);
+  REQUIRE(jumped);
+  REQUIRE(dist > 1);
+
+  // It is the move a search two plies shallower finds
+  Move move;
+  REQUIRE(emm.continuationFromTable(*jumped, tile, 4, &move));
+
+  EMM fresh;
+  fresh.tt.resize(1);
+
+  const BoardPtr next = fresh.solveBestMove(jumped, tile, 2, &dist, false);
+  REQUIRE(next);
+  REQUIRE(*next == *jumped->move(move.source(), move.dest(), tile));
+  REQUIRE(move.dist() == dist);
+
+  // A deeper search for the jump would have left a deeper move, while a
+  // shallower one can take it
+  REQUIRE(!emm.continuationFromTable(*jumped, tile, 6, &move));
+  REQUIRE(emm.continuationFromTable(*jumped, tile, 3, &move));
+
+  emm.jumpsFromTable = false;
+  REQUIRE(!emm.continuationFromTable(*jumped, tile, 4, &move));
+}
+
+TEST_CASE("Whole-turn searches play a turn the table already holds", "[EMM]") {
+  BoardPtr b = std::make_shared<Board>();
+  b->board[0] = Tile(2);
+  b->board[10] = Tile(1);
+  b->board[14] = Tile(1);
+
+  EMM emm;
+  emm.tt.resize(1);
+  emm.wholeTurns = true;
+
+  const Tile tile (1, competitor);
+  const std::vector<Turn> turns = b->getTurns(tile, MoveList::CAPACITY);
+  int dist, moves = 0;
+
+  do {
+    SearchContext context;
+    context.countLeafNodes = true;
+    b = emm.solveBestMove(b, tile, 4, &dist, false, &context);
+    REQUIRE(b);
+
+    // The search for the first move searched the rest of the turn too
+    if (moves++ > 0) REQUIRE(context.leafNodesExplored == 0);
+  } while (dist > 1);
+
+  REQUIRE(moves > 1);
+  REQUIRE(std::any_of(turns.begin(), turns.end(), [&](const Turn& turn) { return turn.board == *b; }));
+}
+
+TEST_CASE("Moves that lead to the same board are searched once", "[EMM]") {
+  // Either 1 can step between them and leave the new 1 in its place
+  BoardPtr b = std::make_shared<Board>();
+  b->board[14] = Tile(1);
+  REQUIRE(*b->move(12, 13, Tile(1)) == *b->move(14, 13, Tile(1)));
+
+  EMM emm;
+  emm.tt.resize(1);
+
+  int dist;
+  SearchContext context;
+  REQUIRE(emm.solveBestMove(b, Tile(1), 4, &dist, false, &context));
+  REQUIRE(context.duplicateSuccessors > 0);
+}
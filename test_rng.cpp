@@ -0,0 +1,21 @@
+#include "catch.hpp"
+
+#include "rng.h"
+
+TEST_CASE("CounterRng draws depend only on seed, stream and position", "[CounterRng]") {
+  CounterRng a(7, 3);
+  CounterRng b(7, 3);
+
+  for (int i=0; i<100; i++) {
+    REQUIRE(a.position() == (uint64_t)i);
+
+    const uint64_t draw = a.next();
+    REQUIRE(draw == b.next());
+    REQUIRE(draw == CounterRng(7, 3).at(i));
+  }
+
+  // Other streams and seeds give other sequences
+  REQUIRE(CounterRng(7, 3).at(0) != CounterRng(7, 4).at(0));
+  REQUIRE(CounterRng(7, 3).at(0) != CounterRng(8, 3).at(0));
+  REQUIRE(CounterRng(3, 7).at(0) != CounterRng(7, 3).at(0));
+}
@@ -0,0 +1,49 @@
+#include <atomic>
+
+#include "catch.hpp"
+
+#include "scheduler.h"
+
+// Sums 1..n by splitting the range into tasks down to single numbers
+static void sumRange(TaskScheduler& scheduler, int lo, int hi, std::atomic<long>* sum) {
+  if (hi - lo == 1) {
+    *sum += lo;
+    return;
+  }
+
+  const int mid = (lo + hi) / 2;
+  TaskScheduler::Group group;
+
+  scheduler.spawn(group, [&scheduler, lo, mid, sum] { sumRange(scheduler, lo, mid, sum); });
+  scheduler.spawn(group, [&scheduler, mid, hi, sum] { sumRange(scheduler, mid, hi, sum); });
+
+  scheduler.wait(group);
+}
+
+TEST_CASE("TaskScheduler runs every task before a wait returns", "[TaskScheduler]") {
+  for (int threads : {1, 2, 4}) {
+    TaskScheduler scheduler(threads);
+    REQUIRE(scheduler.size() == threads);
+    REQUIRE(TaskScheduler::currentThread() == 0);
+
+    std::atomic<long> sum(0);
+    sumRange(scheduler, 1, 1001, &sum);
+
+    REQUIRE(sum == 500500);
+  }
+}
+
+TEST_CASE("TaskScheduler waits only on its group", "[TaskScheduler]") {
+  TaskScheduler scheduler(2);
+  TaskScheduler::Group empty;
+
+  scheduler.wait(empty);
+
+  std::atomic<int> ran(0);
+  TaskScheduler::Group group;
+
+  for (int i=0; i<100; i++) scheduler.spawn(group, [&ran] { ran++; });
+
+  scheduler.wait(group);
+  REQUIRE(ran == 100);
+}
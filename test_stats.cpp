@@ -0,0 +1,30 @@
+#include "catch.hpp"
+
+#include "stats.h"
+
+TEST_CASE("percentile interpolates between ranks", "[Summary]") {
+  const std::vector<double> sorted = {1, 2, 3, 4, 5};
+
+  REQUIRE(percentile(sorted, 0.0) == 1);
+  REQUIRE(percentile(sorted, 0.5) == 3);
+  REQUIRE(percentile(sorted, 1.0) == 5);
+  REQUIRE(percentile(sorted, 0.1) == Approx(1.4));
+  REQUIRE(percentile({7}, 0.9) == 7);
+}
+
+TEST_CASE("summarize a sample", "[Summary]") {
+  const Summary s = summarize({4, 2, 5, 1, 3});
+
+  REQUIRE(s.count == 5);
+  REQUIRE(s.mean == 3);
+  REQUIRE(s.stddev == Approx(1.5811388));
+  REQUIRE(s.confidence95 == Approx(1.96 * 1.5811388 / 2.2360680));
+  REQUIRE(s.min == 1);
+  REQUIRE(s.median == 3);
+  REQUIRE(s.p25 == 2);
+  REQUIRE(s.max == 5);
+
+  const Summary empty = summarize({});
+  REQUIRE(empty.count == 0);
+  REQUIRE(empty.mean == 0);
+}
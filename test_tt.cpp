@@ -0,0 +1,174 @@
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "tt.h"
+
+TEST_CASE("TranspositionTable sizing", "[TranspositionTable]") {
+  TranspositionTable tt;
+
+  TTEntry entry;
+
+  REQUIRE(tt.size() == 0);
+  REQUIRE_FALSE(tt.probe(1, 1, &entry));
+
+  tt.resize(1);
+  REQUIRE(tt.size() == (1 << 20) / 16);
+  REQUIRE((tt.size() & (tt.size() - 1)) == 0);
+
+  tt.resize(0);
+  tt.store(1, 1, 1.0, Move());
+  REQUIRE_FALSE(tt.probe(1, 1, &entry));
+}
+
+TEST_CASE("TranspositionTable probe and store", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  tt.store(42, 3, 1.5, Move(12, 13, 1));
+
+  TTEntry entry;
+  REQUIRE(tt.probe(42, 3, &entry));
+  REQUIRE(entry.value == 1.5);
+  REQUIRE(entry.bestMove == Move(12, 13, 1));
+
+  // Only the same key at the same depth hits
+  REQUIRE_FALSE(tt.probe(42, 2, &entry));
+  REQUIRE_FALSE(tt.probe(43, 3, &entry));
+
+  tt.clear();
+  REQUIRE_FALSE(tt.probe(42, 3, &entry));
+}
+
+TEST_CASE("TranspositionTable prefers deeper entries", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  const uint64_t key = 7;
+  const uint64_t collision = key + tt.size();
+  TTEntry entry;
+
+  tt.store(key, 4, 1.0, Move());
+  tt.store(collision, 2, 2.0, Move());
+  REQUIRE(tt.probe(key, 4, &entry));
+  REQUIRE_FALSE(tt.probe(collision, 2, &entry));
+
+  tt.store(collision, 5, 3.0, Move());
+  REQUIRE_FALSE(tt.probe(key, 4, &entry));
+  REQUIRE(tt.probe(collision, 5, &entry));
+  REQUIRE(entry.value == 3.0);
+
+  // The same position is always refreshed
+  tt.store(collision, 1, 4.0, Move());
+  REQUIRE(tt.probe(collision, 1, &entry));
+  REQUIRE(entry.value == 4.0);
+}
+
+TEST_CASE("TranspositionTable bounds only resolve windows they settle", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  TTEntry entry;
+
+  tt.store(1, 2, 5.0, Move());
+  REQUIRE(tt.probe(1, 2, &entry));
+  REQUIRE(entry.resolves(6.0, 7.0));
+
+  tt.store(1, 2, 5.0, Move(), upperBound);
+  REQUIRE(tt.probe(1, 2, &entry));
+  REQUIRE(entry.resolves(5.0, 7.0));
+  REQUIRE_FALSE(entry.resolves(4.0, 7.0));
+
+  tt.store(1, 2, 5.0, Move(), lowerBound);
+  REQUIRE(tt.probe(1, 2, &entry));
+  REQUIRE(entry.resolves(1.0, 5.0));
+  REQUIRE_FALSE(entry.resolves(1.0, 6.0));
+}
+
+TEST_CASE("TranspositionTable stores every field of an entry", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  TTEntry entry;
+  tt.store(9, 0, -2.25, Move(24, 20, 4), upperBound);
+
+  REQUIRE(tt.probe(9, 0, &entry));
+  REQUIRE(entry.key == 9);
+  REQUIRE(entry.value == -2.25);
+  REQUIRE(entry.depth == 0);
+  REQUIRE(entry.bound == upperBound);
+  REQUIRE(entry.bestMove == Move(24, 20, 4));
+}
+
+TEST_CASE("TranspositionTable never returns a torn entry", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  // Threads store into a handful of slots at once; every entry's value and
+  // depth follow from its key, so a hit mixing two stores would show
+  const int numThreads = 4;
+  const uint64_t collision = tt.size();
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(numThreads, 0);
+
+  for (int t=0; t<numThreads; t++) {
+    threads.emplace_back([&tt, &mismatches, collision, t] {
+      TTEntry entry;
+
+      for (int i=0; i<200000; i++) {
+        const uint64_t key = (i + t) % 8 * collision + i % 4;
+        const int depth = key % 7;
+
+        tt.store(key, depth, key * 0.5f, Move(key % 25, 24 - key % 25, 1));
+
+        const uint64_t other = (i * 7 + t) % 8 * collision + i % 4;
+        if (tt.probe(other, other % 7, &entry)) {
+          if (entry.value != other * 0.5f || entry.bestMove != Move(other % 25, 24 - other % 25, 1)) mismatches[t]++;
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+  for (int t=0; t<numThreads; t++) REQUIRE(mismatches[t] == 0);
+}
+
+TEST_CASE("TranspositionTable replaces entries of earlier searches", "[TranspositionTable]") {
+  TranspositionTable tt;
+  tt.resize(1);
+
+  const uint64_t key = 7;
+  const uint64_t collision = key + tt.size();
+  TTEntry entry;
+
+  tt.store(key, 4, 1.0, Move(1, 2, 1));
+
+  // Entries outlive their search and still order the moves of others
+  tt.newSearch();
+  REQUIRE(tt.probe(key, 4, &entry));
+  REQUIRE(entry.generation != tt.generation());
+
+  Move move;
+  REQUIRE(tt.probeMove(key, &move));
+  REQUIRE(move == Move(1, 2, 1));
+  REQUIRE_FALSE(tt.probeMove(collision, &move));
+
+  REQUIRE(tt.probeAnyDepth(key, &entry));
+  REQUIRE(entry.depth == 4);
+  REQUIRE_FALSE(tt.probeAnyDepth(collision, &entry));
+
+  // A shallower entry of the current search takes the slot of an older one
+  tt.store(collision, 2, 2.0, Move());
+  REQUIRE_FALSE(tt.probe(key, 4, &entry));
+  REQUIRE(tt.probe(collision, 2, &entry));
+  REQUIRE(entry.generation == tt.generation());
+
+  tt.store(key, 1, 3.0, Move());
+  REQUIRE(tt.probe(collision, 2, &entry));
+
+  // Generations wrap around
+  for (int i=0; i<64; i++) tt.newSearch();
+  REQUIRE(tt.probe(collision, 2, &entry));
+  REQUIRE(entry.generation == tt.generation());
+}
@@ -1,6 +1,7 @@
 #ifndef __TILE_H__
 #define __TILE_H__
 
+#include <cstdint>
 #include <ostream>
 
 enum TileType {
@@ -73,4 +74,72 @@ struct Tile {
 
 };
 
+// Two-byte form of a Tile, for undo records and Zobrist keys: the value,
+// offset so that MIN_VALUE is 0, in the low byte and the type in the high
+// one. The board itself keeps only the value byte and the type in its
+// masks, so a cell reads back as a PackedTile. Values must
+// lie in [MIN_VALUE, MAX_VALUE], so input is checked with holds(); a
+// competitor, upgraded every 18 moves, takes over 2,000 moves to outgrow
+// them and then stops being upgraded.
+class PackedTile {
+  public:
+    static const int MIN_VALUE = -128;
+    static const int MAX_VALUE = 127;
+
+    PackedTile()
+        : bits(pack(0, regular)) {}
+
+    PackedTile(int value)
+        : bits(pack(value, regular)) {}
+
+    PackedTile(const Tile& t)
+        : bits(pack(t.value, t.tileType)) {}
+
+    PackedTile(int value, TileType tileType)
+        : bits(pack(value, tileType)) {}
+
+    static bool holds(int value) {
+      return value >= MIN_VALUE && value <= MAX_VALUE;
+    }
+
+    int value() const {
+      return this->valueIndex() + MIN_VALUE;
+    }
+
+    TileType tileType() const {
+      return static_cast<TileType>(bits >> TYPE_SHIFT);
+    }
+
+    // The offset value, which indexes the Zobrist value keys
+    uint8_t valueIndex() const {
+      return bits & VALUE_MASK;
+    }
+
+    operator Tile() const {
+      return Tile(this->value(), this->tileType());
+    }
+
+    bool operator==(const PackedTile& t) const {
+      return bits == t.bits;
+    }
+
+    bool operator!=(const PackedTile& t) const {
+      return bits != t.bits;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const PackedTile t) {
+      return os << Tile(t);
+    }
+
+  private:
+    static const int TYPE_SHIFT = 8;
+    static const uint16_t VALUE_MASK = (1 << TYPE_SHIFT) - 1;
+
+    uint16_t bits;
+
+    static uint16_t pack(int value, TileType tileType) {
+      return static_cast<uint16_t>((tileType << TYPE_SHIFT) | ((value - MIN_VALUE) & VALUE_MASK));
+    }
+};
+
 #endif
@@ -0,0 +1,127 @@
+#include <cstring>
+
+#include "tt.h"
+
+// Layout of a slot's data: the value's bits, depth + 1 (so that an all-zero
+// slot is empty), the bound, the generation and the move's source, dest and
+// distance
+static const int DEPTH_SHIFT = 32;
+static const int BOUND_SHIFT = 40;
+static const int GENERATION_SHIFT = 42;
+static const int GENERATION_MASK = 0x3f;
+static const int SOURCE_SHIFT = 48;
+static const int DEST_SHIFT = 53;
+static const int DIST_SHIFT = 58;
+
+void TranspositionTable::resize(size_t megabytes) {
+  size_t numEntries = 0;
+  const size_t maxEntries = (megabytes << 20) / sizeof(Slot);
+
+  if (maxEntries) {
+    numEntries = 1;
+    while (numEntries * 2 <= maxEntries) numEntries *= 2;
+  }
+
+  slots.reset(numEntries ? new Slot[numEntries] : nullptr);
+  numSlots = numEntries;
+  mask = numEntries ? numEntries - 1 : 0;
+
+  this->clear();
+}
+
+void TranspositionTable::clear() {
+  for (size_t i=0; i<numSlots; i++) {
+    slots[i].check.store(0, std::memory_order_relaxed);
+    slots[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t TranspositionTable::size() const {
+  return numSlots;
+}
+
+void TranspositionTable::newSearch() {
+  uint8_t g = currentGeneration.load(std::memory_order_relaxed);
+  while (!currentGeneration.compare_exchange_weak(g, (g + 1) & GENERATION_MASK, std::memory_order_relaxed));
+}
+
+uint8_t TranspositionTable::generation() const {
+  return currentGeneration.load(std::memory_order_relaxed);
+}
+
+uint64_t TranspositionTable::pack(int depth, float value, Move bestMove, ValueBound bound, uint8_t generation) {
+  uint32_t valueBits;
+  memcpy(&valueBits, &value, sizeof(valueBits));
+
+  return valueBits
+      | (uint64_t)(depth + 1) << DEPTH_SHIFT
+      | (uint64_t)bound << BOUND_SHIFT
+      | (uint64_t)generation << GENERATION_SHIFT
+      | (uint64_t)bestMove.source() << SOURCE_SHIFT
+      | (uint64_t)bestMove.dest() << DEST_SHIFT
+      | (uint64_t)bestMove.dist() << DIST_SHIFT;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t key, uint64_t data) {
+  TTEntry entry;
+  const uint32_t valueBits = data;
+
+  entry.key = key;
+  memcpy(&entry.value, &valueBits, sizeof(entry.value));
+  entry.depth = (int)(data >> DEPTH_SHIFT & 0xff) - 1;
+  entry.bound = (ValueBound)(data >> BOUND_SHIFT & 0x3);
+  entry.generation = data >> GENERATION_SHIFT & GENERATION_MASK;
+  entry.bestMove = Move(data >> SOURCE_SHIFT & 0x1f, data >> DEST_SHIFT & 0x1f, data >> DIST_SHIFT & 0x7);
+
+  return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, int depth, TTEntry* entry) const {
+  TTEntry found;
+  if (!this->probeAnyDepth(key, &found) || found.depth != depth) return false;
+
+  *entry = found;
+
+  return true;
+}
+
+bool TranspositionTable::probeAnyDepth(uint64_t key, TTEntry* entry) const {
+  if (!numSlots) return false;
+
+  const Slot& slot = slots[key & mask];
+  const uint64_t data = slot.data.load(std::memory_order_relaxed);
+  const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+  if ((check ^ data) != key) return false;
+
+  *entry = unpack(key, data);
+
+  return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, float value, Move bestMove, ValueBound bound) {
+  if (!numSlots) return;
+
+  Slot& slot = slots[key & mask];
+  const uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+  const uint64_t oldKey = slot.check.load(std::memory_order_relaxed) ^ oldData;
+
+  const uint8_t generation = this->generation();
+  const TTEntry old = unpack(oldKey, oldData);
+
+  if (depth < old.depth && oldKey != key && old.generation == generation) return;
+
+  const uint64_t data = pack(depth, value, bestMove, bound, generation);
+
+  slot.check.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probeMove(uint64_t key, Move* bestMove) const {
+  TTEntry entry;
+  if (!this->probeAnyDepth(key, &entry)) return false;
+
+  *bestMove = entry.bestMove;
+
+  return *bestMove != Move();
+}
@@ -0,0 +1,86 @@
+#ifndef __TT_H__
+#define __TT_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "move.h"
+
+// Whether a stored value is exact or only bounds the node's value, because
+// the search that produced it was cut off by its alpha/beta window
+enum ValueBound : uint8_t { exactValue, lowerBound, upperBound };
+
+struct TTEntry {
+  uint64_t key = 0;
+  float value = 0.0;
+  int8_t depth = -1;    // -1 marks an empty entry
+  ValueBound bound = exactValue;
+  uint8_t generation = 0;
+  Move bestMove;        // Move() when the node had no move to recommend
+
+  // Whether the stored value answers a search with the given window
+  bool resolves(float alpha, float beta) const {
+    switch (bound) {
+      case lowerBound:
+        return value >= beta;
+      case upperBound:
+        return value <= alpha;
+      default:
+        return true;
+    }
+  }
+};
+
+// Fixed-size, power-of-two transposition table for the expectiminimax
+// search. A lookup only hits for the same key searched to the same depth, so
+// cached values are exactly what a fresh search would return, or bound it
+// when the search was cut off. Keys cover the whole position, so entries
+// stay valid from one search to the next.
+//
+// Each search starts a new generation. On a collision an entry of an
+// earlier generation is replaced, and within a generation the deeper (more
+// expensive) result is kept.
+//
+// Threads probe and store concurrently without locks. A slot holds an entry
+// packed into 64 bits next to its key XORed with them, so a slot torn by two
+// racing stores fails the key check and reads as a miss.
+class TranspositionTable {
+  public:
+    // Sizes the table to the largest power-of-two number of entries that fits
+    // in the given number of megabytes; 0 disables it.
+    void resize(size_t megabytes);
+    void clear();
+    size_t size() const;
+
+    // Ages every entry by one generation
+    void newSearch();
+    uint8_t generation() const;
+
+    bool probe(uint64_t key, int depth, TTEntry* entry) const;
+    void store(uint64_t key, int depth, float value, Move bestMove, ValueBound bound = exactValue);
+
+    // The entry stored for the key, whatever its depth
+    bool probeAnyDepth(uint64_t key, TTEntry* entry) const;
+
+    // The best move stored for the key at any depth, to search first at
+    // another depth
+    bool probeMove(uint64_t key, Move* bestMove) const;
+
+  private:
+    struct Slot {
+      std::atomic<uint64_t> check;
+      std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t numSlots = 0;
+    uint64_t mask = 0;
+    std::atomic<uint8_t> currentGeneration {0};
+
+    static uint64_t pack(int depth, float value, Move bestMove, ValueBound bound, uint8_t generation);
+    static TTEntry unpack(uint64_t key, uint64_t data);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef __ZOBRIST_H__
+#define __ZOBRIST_H__
+
+#include <cstdint>
+
+#include "constants.h"
+#include "rng.h"
+#include "tile.h"
+
+const int MAX_TIMER = 32;
+const int MAX_BONUS = 256;
+
+const int TILE_CLASSES = competitor + 1;
+
+// Random keys for every (position, state) pair of a board, XORed together to
+// give a 64-bit board hash. A tile's key is the key of its value XORed with
+// that of its type. Keys for a timer or bonus of 0 are 0, so cells without
+// one contribute nothing.
+struct ZobristTable {
+  uint64_t cell[BOARD_SIZE][256];
+  uint64_t cellType[BOARD_SIZE][TILE_CLASSES];
+  uint64_t timer[BOARD_SIZE][MAX_TIMER];
+  uint64_t bonus[BOARD_SIZE][MAX_BONUS];
+  uint64_t band[PROBABILITY_INTERVALS];
+
+  // Keys for the tile to be placed, distinguishing max nodes in the search
+  uint64_t nextTile[256];
+  uint64_t nextTileType[TILE_CLASSES];
+
+  // Key of searches over whole turns, whose nodes have other values
+  uint64_t wholeTurns;
+};
+
+constexpr ZobristTable makeZobristTable() {
+  ZobristTable z {};
+  uint64_t state = 0x2545f4914f6cdd1dULL;
+
+  for (int pos=0; pos<BOARD_SIZE; pos++) {
+    for (int i=0; i<256; i++) z.cell[pos][i] = splitmix64(&state);
+    for (int i=1; i<MAX_TIMER; i++) z.timer[pos][i] = splitmix64(&state);
+    for (int i=1; i<MAX_BONUS; i++) z.bonus[pos][i] = splitmix64(&state);
+  }
+
+  for (int i=0; i<PROBABILITY_INTERVALS; i++) z.band[i] = splitmix64(&state);
+  for (int i=0; i<256; i++) z.nextTile[i] = splitmix64(&state);
+  z.wholeTurns = splitmix64(&state);
+
+  for (int pos=0; pos<BOARD_SIZE; pos++) {
+    for (int i=0; i<TILE_CLASSES; i++) z.cellType[pos][i] = splitmix64(&state);
+  }
+
+  for (int i=0; i<TILE_CLASSES; i++) z.nextTileType[i] = splitmix64(&state);
+
+  return z;
+}
+
+// Defined in board.cpp
+extern const ZobristTable ZOBRIST;
+
+inline uint64_t cellKey(int pos, PackedTile t) {
+  return ZOBRIST.cell[pos][t.valueIndex()] ^ ZOBRIST.cellType[pos][t.tileType()];
+}
+
+inline uint64_t nextTileKey(PackedTile t) {
+  return ZOBRIST.nextTile[t.valueIndex()] ^ ZOBRIST.nextTileType[t.tileType()];
+}
+
+#endif